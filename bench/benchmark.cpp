@@ -0,0 +1,356 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Benchmarks of the structural analysis on synthetic DAEs
+ *
+ * Every benchmark reports the time per phase (building the problem, solving the 
+ * LAP and calculating the smallest offsets) and the throughput in nonzeros per second.
+ * Machine readable output: daestruct_bench --benchmark_out=result.json --benchmark_out_format=json
+ *
+ * The row kernel benchmarks compare the scalar, AVX2 and AVX-512 scans of the LAP 
+ * (see row_kernels.hpp), e.g. daestruct_bench --benchmark_filter='row_scan|lap_isa'
+ *
+ * The LAP engines (lap() and lap_cost_scaling()) are compared on 10^5 to 10^7 nonzeros 
+ * by daestruct_bench --benchmark_filter=lap_engine, the random models take long with lap().
+ * The augmentation modes of lap() (single rows, phases, both or parallel searches on all cores) 
+ * by --benchmark_filter=lap_augmentation, the initializations by --benchmark_filter=lap_initialization.
+ * The dense LAP of tiny matrices against the sparse one by --benchmark_filter=lap_small.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+
+#include "lap.hpp"
+#include "row_kernels.hpp"
+#include "generators.hpp"
+
+using namespace daestruct::bench;
+
+typedef std::chrono::steady_clock bench_clock;
+typedef std::function<InputProblem(size_t)> generator;
+
+static double seconds(bench_clock::time_point from, bench_clock::time_point to) {
+  return std::chrono::duration<double>(to - from).count();
+}
+
+/**
+ * Run the structural analysis on a problem of size state.range(0) created by gen
+ * The benchmark time covers the analysis only, building is reported separately.
+ */
+static void BM_analyse(benchmark::State& state, generator gen) {
+  const size_t n = state.range(0);
+  double build = 0, assign = 0, fixpoint = 0;
+  size_t dimension = 0, nnz = 0;
+
+  for (auto _ : state) {
+    state.PauseTiming();
+    const auto t0 = bench_clock::now();
+    InputProblem p = gen(n);
+    const auto t1 = bench_clock::now();
+    dimension = p.dimension;
+    nnz = nonzeros(p);
+    state.ResumeTiming();
+
+    const auto t2 = bench_clock::now();
+    solution sol = lap(p.sigma);
+    const auto t3 = bench_clock::now();
+    std::vector<int> c(p.dimension), d(p.dimension);
+    solveByFixedPoint(sol.rowsol, p.sigma, c, d);
+    const auto t4 = bench_clock::now();
+
+    benchmark::DoNotOptimize(c.data());
+    benchmark::DoNotOptimize(d.data());
+
+    build += seconds(t0, t1);
+    assign += seconds(t2, t3);
+    fixpoint += seconds(t3, t4);
+  }
+
+  state.counters["dimension"] = dimension;
+  state.counters["nonzeros"] = nnz;
+  state.counters["build_s"] = benchmark::Counter(build, benchmark::Counter::kAvgIterations);
+  state.counters["lap_s"] = benchmark::Counter(assign, benchmark::Counter::kAvgIterations);
+  state.counters["fixpoint_s"] = benchmark::Counter(fixpoint, benchmark::Counter::kAvgIterations);
+  state.counters["nnz_per_s"] = benchmark::Counter(nnz, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+static InputProblem random_sparse(size_t n) {
+  /* mostly algebraic, some first and few second order derivatives */
+  return random_dae(n, 4, { 0.7, 0.2, 0.1 }, 42);
+}
+
+static InputProblem random_high_order(size_t n) {
+  return random_dae(n, 4, { 0.4, 0.2, 0.2, 0.1, 0.1 }, 42);
+}
+
+static InputProblem plant(size_t n) {
+  return block_plant(n, 32, 42);
+}
+
+/* sizes are the generator argument, i.e. stages for ladders and pendulums */
+BENCHMARK_CAPTURE(BM_analyse, rc_ladder, &rc_ladder)
+  ->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_analyse, rlc_ladder, &rlc_ladder)
+  ->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_analyse, chained_pendulums, &chained_pendulums)
+  ->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_analyse, random_sparse, &random_sparse)
+  ->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_analyse, random_high_order, &random_high_order)
+  ->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_analyse, block_plant, &plant)
+  ->RangeMultiplier(10)->Range(1000, 100000)->Unit(benchmark::kMillisecond);
+
+using namespace daestruct::kernels;
+
+/**
+ * Restores the row kernels active on construction, so the benchmarks after
+ * one that selects an isa keep the default dispatch
+ */
+struct isa_scope {
+  const isa previous = active_isa();
+  ~isa_scope() { select_isa(previous); }
+};
+
+/**
+ * The row scan of the row reduction (reduced costs, minimum and second minimum)
+ * over 1024 rows of state.range(0) entries each
+ */
+static void BM_row_scan(benchmark::State& state, isa which) {
+  const isa_scope scope;
+  if (!select_isa(which)) {
+    state.SkipWithError("not supported by this CPU");
+    return;
+  }
+
+  const size_t rows = 1024, length = state.range(0);
+  daestruct::sigma_matrix sigma(std::max(4 * length, rows));
+  std::vector<int> v(sigma.dimension());
+  for (size_t j = 0; j < v.size(); j++)
+    v[j] = -int(j % 7);
+  for (size_t i = 0; i < rows; i++)
+    for (size_t k = 0; k < length; k++)
+      sigma.push_back(i, 4 * k + i % 4, -int((i + k) % 3));
+
+  std::vector<int> h(sigma.dimension());
+  for (auto _ : state) {
+    for (size_t i = 0; i < rows; i++) {
+      const daestruct::sigma_matrix::row_t& row = sigma.row(i);
+      reduced_costs(entries(row), row.nnz(), v.data(), h.data());
+      benchmark::DoNotOptimize(two_smallest(h.data(), row.nnz()));
+    }
+  }
+
+  state.counters["rows_per_s"] = benchmark::Counter(rows, benchmark::Counter::kIsIterationInvariantRate);
+}
+
+/**
+ * The LAP alone with the given row kernels
+ */
+static void BM_lap_isa(benchmark::State& state, generator gen, isa which) {
+  const isa_scope scope;
+  if (!select_isa(which)) {
+    state.SkipWithError("not supported by this CPU");
+    return;
+  }
+
+  const InputProblem p = gen(state.range(0));
+  for (auto _ : state) {
+    solution sol = lap(p.sigma);
+    benchmark::DoNotOptimize(sol.cost);
+  }
+  state.counters["nnz_per_s"] = benchmark::Counter(nonzeros(p), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK_CAPTURE(BM_row_scan, scalar, ISA_SCALAR)->RangeMultiplier(4)->Range(4, 256);
+BENCHMARK_CAPTURE(BM_row_scan, avx2, ISA_AVX2)->RangeMultiplier(4)->Range(4, 256);
+BENCHMARK_CAPTURE(BM_row_scan, avx512, ISA_AVX512)->RangeMultiplier(4)->Range(4, 256);
+
+BENCHMARK_CAPTURE(BM_lap_isa, random_sparse_scalar, &random_sparse, ISA_SCALAR)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_isa, random_sparse_avx2, &random_sparse, ISA_AVX2)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_isa, random_sparse_avx512, &random_sparse, ISA_AVX512)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_isa, block_plant_scalar, &plant, ISA_SCALAR)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_isa, block_plant_avx2, &plant, ISA_AVX2)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_isa, block_plant_avx512, &plant, ISA_AVX512)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+
+using daestruct::analysis::AssignmentEngine;
+using daestruct::analysis::ENGINE_JONKER_VOLGENANT;
+using daestruct::analysis::ENGINE_COST_SCALING;
+
+/**
+ * The LAP alone, solved by the given engine
+ */
+static void BM_lap_engine(benchmark::State& state, generator gen, AssignmentEngine engine) {
+  const InputProblem p = gen(state.range(0));
+  size_t work = 0;
+  for (auto _ : state) {
+    solution sol = engine == ENGINE_COST_SCALING ? lap_cost_scaling(p.sigma) : lap(p.sigma);
+    benchmark::DoNotOptimize(sol.cost);
+    work = sol.augmentations;
+  }
+  state.counters["nonzeros"] = nonzeros(p);
+  state.counters["augmentations"] = work;
+  state.counters["nnz_per_s"] = benchmark::Counter(nonzeros(p), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+/* the sizes are about 10^5, 10^6 and 10^7 nonzeros */
+BENCHMARK_CAPTURE(BM_lap_engine, chain_jv, &chained_pendulums, ENGINE_JONKER_VOLGENANT)
+  ->Arg(7000)->Arg(70000)->Arg(700000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_engine, chain_cost_scaling, &chained_pendulums, ENGINE_COST_SCALING)
+  ->Arg(7000)->Arg(70000)->Arg(700000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_engine, ladder_jv, &rlc_ladder, ENGINE_JONKER_VOLGENANT)
+  ->Arg(12500)->Arg(125000)->Arg(1250000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_engine, ladder_cost_scaling, &rlc_ladder, ENGINE_COST_SCALING)
+  ->Arg(12500)->Arg(125000)->Arg(1250000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_engine, random_jv, &random_sparse, ENGINE_JONKER_VOLGENANT)
+  ->Arg(25000)->Arg(250000)->Arg(2500000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_engine, random_cost_scaling, &random_sparse, ENGINE_COST_SCALING)
+  ->Arg(25000)->Arg(250000)->Arg(2500000)->Unit(benchmark::kMillisecond);
+
+/**
+ * The LAP alone, with the given augmentation of the rows left free by the initialization
+ */
+static void BM_lap_augmentation(benchmark::State& state, generator gen, augmentation_mode mode) {
+  const InputProblem p = gen(state.range(0));
+  size_t searches = 0, scanned = 0, repeated = 0;
+  lap_options options;
+  options.augmentation = mode;
+  for (auto _ : state) {
+    solution sol = lap(p.sigma, options);
+    benchmark::DoNotOptimize(sol.cost);
+    searches = sol.augmentations;
+    scanned = sol.scanned_columns;
+    repeated = sol.repeated_searches;
+  }
+  state.counters["searches"] = searches;
+  state.counters["scanned_columns"] = scanned;
+  state.counters["repeated"] = repeated;
+}
+
+BENCHMARK_CAPTURE(BM_lap_augmentation, random_sparse_rows, &random_sparse, AUGMENT_ROWS)
+  ->Arg(25000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_augmentation, random_sparse_phases, &random_sparse, AUGMENT_PHASES)
+  ->Arg(25000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_augmentation, random_sparse_adaptive, &random_sparse, AUGMENT_ADAPTIVE)
+  ->Arg(25000)->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_augmentation, random_sparse_parallel, &random_sparse, AUGMENT_PARALLEL)
+  ->Arg(25000)->Arg(100000)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK_CAPTURE(BM_lap_augmentation, block_plant_rows, &plant, AUGMENT_ROWS)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_augmentation, block_plant_phases, &plant, AUGMENT_PHASES)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_augmentation, block_plant_adaptive, &plant, AUGMENT_ADAPTIVE)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_augmentation, block_plant_parallel, &plant, AUGMENT_PARALLEL)
+  ->Arg(100000)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+/**
+ * The LAP alone with the given initialization, reporting the rows assigned by each stage
+ */
+static void BM_lap_initialization(benchmark::State& state, generator gen, lap_initialization initialization) {
+  const InputProblem p = gen(state.range(0));
+  lap_options options;
+  options.initialization = initialization;
+  solution sol;
+  for (auto _ : state) {
+    sol = lap(p.sigma, options);
+    benchmark::DoNotOptimize(sol.cost);
+  }
+  state.counters["initialized"] = sol.initialized_rows;
+  state.counters["row_reduced"] = sol.row_reduced_rows;
+  state.counters["augmented"] = sol.augmented_rows;
+}
+
+BENCHMARK_CAPTURE(BM_lap_initialization, random_sparse_columns, &random_sparse, INIT_COLUMN_REDUCTION)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_initialization, random_sparse_karp_sipser, &random_sparse, INIT_KARP_SIPSER)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_initialization, block_plant_columns, &plant, INIT_COLUMN_REDUCTION)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_initialization, block_plant_karp_sipser, &plant, INIT_KARP_SIPSER)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_initialization, rlc_ladder_columns, &rlc_ladder, INIT_COLUMN_REDUCTION)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_lap_initialization, rlc_ladder_karp_sipser, &rlc_ladder, INIT_KARP_SIPSER)
+  ->Arg(100000)->Unit(benchmark::kMillisecond);
+
+/**
+ * The LAP of 1024 tiny random matrices of dimension state.range(0) (four entries per row), 
+ * dense or sparse
+ */
+static void BM_lap_small(benchmark::State& state, bool dense) {
+  const size_t n = state.range(0);
+  std::vector<daestruct::sigma_matrix> blocks;
+  std::srand(42);
+  for (size_t b = 0; b < 1024; b++) {
+    blocks.emplace_back(n);
+    for (size_t i = 0; i < n; i++) {
+      blocks.back().insert(i, i, -(std::rand() % 3));
+      for (int k = 0; k < 3; k++)
+	blocks.back().insert(i, std::rand() % n, -(std::rand() % 3));
+    }
+  }
+
+  lap_options options;
+  options.dense_small_matrices = dense;
+  for (auto _ : state)
+    for (const auto& block : blocks)
+      benchmark::DoNotOptimize(lap(block, options).cost);
+  state.counters["matrices_per_s"] = benchmark::Counter(blocks.size(), benchmark::Counter::kIsIterationInvariantRate);
+}
+
+BENCHMARK_CAPTURE(BM_lap_small, sparse, false)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Unit(benchmark::kMicrosecond);
+BENCHMARK_CAPTURE(BM_lap_small, dense, true)->Arg(4)->Arg(8)->Arg(16)->Arg(32)->Unit(benchmark::kMicrosecond);
+
+/* discards everything, the library reports progress on std::cout */
+struct null_buffer : public std::streambuf {
+  int overflow(int c) { return c; }
+};
+
+int main(int argc, char** argv) {
+  benchmark::Initialize(&argc, argv);
+  if (benchmark::ReportUnrecognizedArguments(argc, argv))
+    return 1;
+
+  std::ostream out(std::cout.rdbuf());
+  null_buffer null;
+  std::cout.rdbuf(&null);
+
+  std::unique_ptr<benchmark::BenchmarkReporter> reporter(benchmark::CreateDefaultDisplayReporter());
+  reporter->SetOutputStream(&out);
+  reporter->SetErrorStream(&std::cerr);
+  benchmark::RunSpecifiedBenchmarks(reporter.get());
+
+  std::cout.rdbuf(out.rdbuf());
+  benchmark::Shutdown();
+  return 0;
+}
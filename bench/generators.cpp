@@ -0,0 +1,160 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <random>
+#include <algorithm>
+
+#include "generators.hpp"
+
+namespace daestruct {
+  namespace bench {
+
+    /* set the incidence of variable j in equation i as derivative order */
+    static inline void set(InputProblem& p, size_t i, size_t j, int der) {
+      p.sigma.insert(i, j, -der);
+    }
+
+    InputProblem rc_ladder(size_t n) {
+      InputProblem p(3*n + 1);
+      auto v = [](size_t k) { return k == 0 ? 0 : 3*k - 2; };
+      auto iR = [](size_t k) { return 3*k - 1; };
+      auto iC = [](size_t k) { return 3*k; };
+
+      set(p, 0, v(0), 0);
+      for (size_t k = 1; k <= n; k++) {
+	set(p, 3*k - 2, iR(k), 0);
+	set(p, 3*k - 2, v(k-1), 0);
+	set(p, 3*k - 2, v(k), 0);
+
+	set(p, 3*k - 1, v(k), 1);
+	set(p, 3*k - 1, iC(k), 0);
+
+	set(p, 3*k, iR(k), 0);
+	set(p, 3*k, iC(k), 0);
+	if (k < n)
+	  set(p, 3*k, iR(k+1), 0);
+      }
+      return p;
+    }
+
+    InputProblem rlc_ladder(size_t n) {
+      InputProblem p(3*n + 1);
+      auto v = [](size_t k) { return k == 0 ? 0 : 3*k - 2; };
+      auto iL = [](size_t k) { return 3*k - 1; };
+      auto iC = [](size_t k) { return 3*k; };
+
+      set(p, 0, v(0), 0);
+      for (size_t k = 1; k <= n; k++) {
+	set(p, 3*k - 2, iL(k), 1);
+	set(p, 3*k - 2, v(k-1), 0);
+	set(p, 3*k - 2, v(k), 0);
+
+	set(p, 3*k - 1, v(k), 1);
+	set(p, 3*k - 1, iC(k), 0);
+
+	set(p, 3*k, iL(k), 0);
+	set(p, 3*k, iC(k), 0);
+	if (k < n)
+	  set(p, 3*k, iL(k+1), 0);
+      }
+      return p;
+    }
+
+    InputProblem chained_pendulums(size_t n) {
+      InputProblem p(3*n);
+      auto x = [](size_t k) { return 3*k; };
+      auto y = [](size_t k) { return 3*k + 1; };
+      auto F = [](size_t k) { return 3*k + 2; };
+
+      for (size_t k = 0; k < n; k++) {
+	set(p, 3*k, x(k), 0);
+	set(p, 3*k, y(k), 0);
+	if (k > 0) {
+	  set(p, 3*k, x(k-1), 0);
+	  set(p, 3*k, y(k-1), 0);
+	}
+
+	set(p, 3*k + 1, x(k), 2);
+	set(p, 3*k + 1, F(k), 0);
+	set(p, 3*k + 2, y(k), 2);
+	set(p, 3*k + 2, F(k), 0);
+	if (k > 0) {
+	  set(p, 3*k + 1, x(k-1), 0);
+	  set(p, 3*k + 2, y(k-1), 0);
+	}
+	if (k + 1 < n) {
+	  set(p, 3*k + 1, F(k+1), 0);
+	  set(p, 3*k + 1, x(k+1), 0);
+	  set(p, 3*k + 2, F(k+1), 0);
+	  set(p, 3*k + 2, y(k+1), 0);
+	}
+      }
+      return p;
+    }
+
+    /* fill rows [offset, offset + n) and columns [offset, offset + n) with a random DAE */
+    static void random_block(InputProblem& p, size_t offset, size_t n, size_t k, 
+			     std::discrete_distribution<int>& der, std::mt19937& rng) {
+      std::vector<size_t> perm(n);
+      for (size_t i = 0; i < n; i++)
+	perm[i] = i;
+      std::shuffle(perm.begin(), perm.end(), rng);
+
+      std::uniform_int_distribution<size_t> col(0, n - 1);
+      for (size_t i = 0; i < n; i++) {
+	set(p, offset + i, offset + perm[i], der(rng));
+	for (size_t e = 1; e < k; e++)
+	  set(p, offset + i, offset + col(rng), der(rng));
+      }
+    }
+
+    InputProblem random_dae(size_t n, size_t k, const std::vector<double>& der_weights, unsigned seed) {
+      InputProblem p(n);
+      std::mt19937 rng(seed);
+      std::discrete_distribution<int> der(der_weights.begin(), der_weights.end());
+      random_block(p, 0, n, k, der, rng);
+      return p;
+    }
+
+    InputProblem block_plant(size_t n, size_t b, unsigned seed) {
+      const size_t blocks = std::max<size_t>(n / b, 1);
+      InputProblem p(blocks * b);
+      std::mt19937 rng(seed);
+      std::discrete_distribution<int> der({ 0.8, 0.15, 0.05 });
+      std::uniform_int_distribution<size_t> local(0, b - 1);
+
+      for (size_t m = 0; m < blocks; m++) {
+	random_block(p, m*b, b, 4, der, rng);
+
+	/* connectors: a few algebraic couplings to the previous block */
+	if (m > 0)
+	  for (size_t e = 0; e < 2; e++)
+	    set(p, m*b + local(rng), (m-1)*b + local(rng), 0);
+      }
+      return p;
+    }
+
+    size_t nonzeros(const InputProblem& p) {
+      size_t nnz = 0;
+      for (size_t i = 0; i < p.sigma.dimension(); i++)
+	nnz += p.sigma.row(i).nnz();
+      return nnz;
+    }
+  }
+}
@@ -0,0 +1,84 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DAESTRUCT_BENCH_GENERATORS_HPP
+#define DAESTRUCT_BENCH_GENERATORS_HPP
+
+#include <daestruct/analysis.hpp>
+
+namespace daestruct {
+  namespace bench {
+
+    using namespace daestruct::analysis;
+
+    /**
+     * RC ladder with n stages driven by a voltage source
+     * Variables: v[0], (v[k], iR[k], iC[k]) for k = 1..n
+     * 
+     *   0)        v[0] = sin(time)
+     *   3k - 2)   R*iR[k] = v[k-1] - v[k]
+     *   3k - 1)   C*der(v[k]) = iC[k]
+     *   3k)       iR[k] = iC[k] + iR[k+1]   (iR[n+1] = 0)
+     */
+    InputProblem rc_ladder(size_t n);
+
+    /**
+     * RLC ladder with n stages (series R-L, shunt C) driven by a voltage source
+     * Variables: v[0], (v[k], iL[k], iC[k]) for k = 1..n
+     * 
+     *   0)        v[0] = sin(time)
+     *   3k - 2)   L*der(iL[k]) = v[k-1] - v[k] - R*iL[k]
+     *   3k - 1)   C*der(v[k]) = iC[k]
+     *   3k)       iL[k] = iC[k] + iL[k+1]   (iL[n+1] = 0)
+     */
+    InputProblem rlc_ladder(size_t n);
+
+    /**
+     * n cartesian pendulums, each one hanging from the previous one
+     * Variables: (x[k], y[k], F[k]) for k = 0..n-1
+     *
+     *   3k)       (x[k] - x[k-1])² + (y[k] - y[k-1])² = l²
+     *   3k + 1)   der(der(x[k])) = F[k]*(x[k] - x[k-1]) - F[k+1]*(x[k+1] - x[k])
+     *   3k + 2)   der(der(y[k])) = F[k]*(y[k] - y[k-1]) - F[k+1]*(y[k+1] - y[k]) - g
+     */
+    InputProblem chained_pendulums(size_t n);
+
+    /**
+     * A random sparse n x n DAE with (about) k entries per equation
+     * The derivative order of each entry is drawn from the weights in der_weights
+     * (der_weights[m] is the relative frequency of order m). A hidden random 
+     * transversal keeps the problem structurally nonsingular.
+     */
+    InputProblem random_dae(size_t n, size_t k, const std::vector<double>& der_weights, unsigned seed);
+
+    /**
+     * A plant model of n / b blocks with b equations each
+     * Every block is a small random DAE (see random_dae) and is coupled to its 
+     * predecessor by a few algebraic entries, as connected sub-models are.
+     */
+    InputProblem block_plant(size_t n, size_t b, unsigned seed);
+
+    /**
+     * number of nonzeros of the given problem
+     */
+    size_t nonzeros(const InputProblem& p);
+  }
+}
+
+#endif
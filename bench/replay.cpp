@@ -0,0 +1,309 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Replays a recorded stream of structural changes and reports the latency per event
+ *
+ * usage: daestruct_replay [--keep-duals] <stream> [repetitions]
+ *
+ * Stream format (one command per line, '#' starts a comment):
+ *
+ *   problem <dimension>                   the original problem
+ *   e <equation> <unknown> <derivative>   an entry of the original problem
+ *   problem_file <path>                   the original problem from a Matrix Market or
+ *                                         binary file (see daestruct_input_read)
+ *
+ *   remove_unknown <unknown>              see daestruct_diff_remove_unknown
+ *   remove_equation <equation>            see daestruct_diff_remove_equation
+ *   add_unknown                           see daestruct_diff_add_unknown
+ *   add_equation                          see daestruct_diff_add_equation
+ *   set_existing <new eq> <unknown> <der> see daestruct_diff_set_existing
+ *   set_new <new eq> <new unknown> <der>  see daestruct_diff_set_new
+ *   commit                                ends an event and analyses the changed problem
+ *
+ * Indices of an event refer to the problem as it was before that event, new
+ * equations and unknowns are counted from 0 within their event.
+ * Modeling time covers building the diff and the changed problem 
+ * (daestruct_change), analysis time covers daestruct_changed_analyse. Every
+ * repetition starts again from the original problem.
+ * The work of the LAP is reported as the augmenting path searches and the 
+ * columns they scanned per event. --keep-duals warm-starts every event with 
+ * the LAP duals instead of the offsets (see DAESTRUCT_KEEP_DUALS).
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <daestruct.h>
+#include <daestruct/variable_structure.h>
+
+typedef std::chrono::steady_clock replay_clock;
+
+enum op_kind { REMOVE_UNKNOWN, REMOVE_EQUATION, ADD_UNKNOWN, ADD_EQUATION, SET_EXISTING, SET_NEW };
+
+struct operation {
+  op_kind kind;
+  int args[3];
+};
+
+typedef std::vector<operation> event;
+
+struct entry {
+  int equation, unknown, derivative;
+};
+
+struct stream {
+  int dimension = 0;
+  std::string problem_file;
+  std::vector<entry> entries;
+  std::vector<event> events;
+};
+
+struct latencies {
+  std::vector<double> model, analysis, total;
+  std::vector<double> augmentations, scanned;
+};
+
+static bool parse_stream(std::istream& in, stream& s) {
+  std::string line, cmd;
+  event current;
+  size_t lineno = 0;
+
+  while (std::getline(in, line)) {
+    lineno++;
+    line = line.substr(0, line.find('#'));
+    std::istringstream words(line);
+    if (!(words >> cmd))
+      continue;
+
+    operation op = { ADD_UNKNOWN, { 0, 0, 0 } };
+    int arity = 0;
+    if (cmd == "problem") {
+      words >> s.dimension;
+    } else if (cmd == "problem_file") {
+      words >> s.problem_file;
+    } else if (cmd == "e") {
+      entry e;
+      words >> e.equation >> e.unknown >> e.derivative;
+      s.entries.push_back(e);
+    } else if (cmd == "commit") {
+      s.events.push_back(current);
+      current.clear();
+    } else {
+      if (cmd == "remove_unknown") { op.kind = REMOVE_UNKNOWN; arity = 1; }
+      else if (cmd == "remove_equation") { op.kind = REMOVE_EQUATION; arity = 1; }
+      else if (cmd == "add_unknown") { op.kind = ADD_UNKNOWN; arity = 0; }
+      else if (cmd == "add_equation") { op.kind = ADD_EQUATION; arity = 0; }
+      else if (cmd == "set_existing") { op.kind = SET_EXISTING; arity = 3; }
+      else if (cmd == "set_new") { op.kind = SET_NEW; arity = 3; }
+      else {
+	std::cerr << "line " << lineno << ": unknown command '" << cmd << "'" << std::endl;
+	return false;
+      }
+      for (int k = 0; k < arity; k++)
+	words >> op.args[k];
+      current.push_back(op);
+    }
+
+    if (words.fail()) {
+      std::cerr << "line " << lineno << ": missing argument for '" << cmd << "'" << std::endl;
+      return false;
+    }
+  }
+
+  if (!current.empty())
+    std::cerr << "ignoring " << current.size() << " operations after the last commit" << std::endl;
+
+  if (s.dimension <= 0 && s.problem_file.empty()) {
+    std::cerr << "no problem given" << std::endl;
+    return false;
+  }
+  return true;
+}
+
+static struct daestruct_diff* build_diff(const event& ev) {
+  struct daestruct_diff* diff = daestruct_diff_new();
+  for (const operation& op : ev)
+    switch (op.kind) {
+    case REMOVE_UNKNOWN: daestruct_diff_remove_unknown(diff, op.args[0]); break;
+    case REMOVE_EQUATION: daestruct_diff_remove_equation(diff, op.args[0]); break;
+    case ADD_UNKNOWN: daestruct_diff_add_unknown(diff); break;
+    case ADD_EQUATION: daestruct_diff_add_equation(diff); break;
+    case SET_EXISTING: daestruct_diff_set_existing(diff, op.args[0], op.args[1], op.args[2]); break;
+    case SET_NEW: daestruct_diff_set_new(diff, op.args[0], op.args[1], op.args[2]); break;
+    }
+  return diff;
+}
+
+static double seconds(replay_clock::time_point from, replay_clock::time_point to) {
+  return std::chrono::duration<double>(to - from).count();
+}
+
+/**
+ * replay all events once, starting with the original problem 
+ * returns the number of structurally singular results
+ */
+static size_t replay(const stream& s, bool keep_duals, latencies& lat) {
+  struct daestruct_input* input = s.problem_file.empty() ? daestruct_input_create(s.dimension) 
+                                                        : daestruct_input_read(s.problem_file.c_str());
+  daestruct_input_set_option(input, DAESTRUCT_KEEP_DUALS, keep_duals);
+  for (const entry& e : s.entries)
+    daestruct_input_set(input, e.unknown, e.equation, e.derivative);
+
+  struct daestruct_result* result = daestruct_analyse(input);
+  struct daestruct_changed* changed = NULL;
+  size_t singular = 0;
+
+  for (const event& ev : s.events) {
+    const auto t0 = replay_clock::now();
+    struct daestruct_diff* diff = build_diff(ev);
+    struct daestruct_changed* next = changed ? daestruct_change(changed, result, diff) 
+                                             : daestruct_change_orig(input, result, diff);
+    const auto t1 = replay_clock::now();
+    struct daestruct_result* next_result = daestruct_changed_analyse(next);
+    const auto t2 = replay_clock::now();
+
+    if (daestruct_result_status(next_result) != DAESTRUCT_OK)
+      singular++;
+
+    lat.model.push_back(seconds(t0, t1));
+    lat.analysis.push_back(seconds(t1, t2));
+    lat.total.push_back(seconds(t0, t2));
+    lat.augmentations.push_back(daestruct_result_augmentations(next_result));
+    lat.scanned.push_back(daestruct_result_scanned_columns(next_result));
+
+    daestruct_diff_delete(diff);
+    if (changed)
+      daestruct_changed_delete(changed);
+    daestruct_result_delete(result);
+    changed = next;
+    result = next_result;
+  }
+
+  if (changed)
+    daestruct_changed_delete(changed);
+  daestruct_result_delete(result);
+  daestruct_input_delete(input);
+  return singular;
+}
+
+/* nearest-rank percentile of sorted samples */
+static double percentile(const std::vector<double>& sorted, double p) {
+  const size_t rank = std::max<size_t>(1, std::ceil(p / 100.0 * sorted.size()));
+  return sorted[rank - 1];
+}
+
+static void report(std::ostream& out, const char* name, std::vector<double> samples, double scale) {
+  std::sort(samples.begin(), samples.end());
+  double sum = 0;
+  for (double x : samples)
+    sum += x;
+
+  out << std::left << std::setw(10) << name << std::right << std::fixed << std::setprecision(1)
+      << std::setw(12) << percentile(samples, 50) * scale
+      << std::setw(12) << percentile(samples, 99) * scale
+      << std::setw(12) << samples.back() * scale
+      << std::setw(12) << sum * scale << std::endl;
+}
+
+/* discards everything, the library reports progress on std::cout */
+struct null_buffer : public std::streambuf {
+  int overflow(int c) { return c; }
+};
+
+static void header(std::ostream& out, const char* unit) {
+  out << std::left << std::setw(10) << unit << std::right 
+      << std::setw(12) << "p50" << std::setw(12) << "p99" 
+      << std::setw(12) << "max" << std::setw(12) << "sum" << std::endl;
+}
+
+int main(int argc, char** argv) {
+  const bool keep_duals = argc > 1 && std::string(argv[1]) == "--keep-duals";
+  if (keep_duals) {
+    argv++;
+    argc--;
+  }
+
+  if (argc < 2) {
+    std::cerr << "usage: " << argv[0] << " [--keep-duals] <stream> [repetitions]" << std::endl;
+    return 1;
+  }
+
+  std::ifstream in(argv[1]);
+  if (!in) {
+    std::cerr << "cannot open " << argv[1] << std::endl;
+    return 1;
+  }
+
+  stream s;
+  if (!parse_stream(in, s))
+    return 1;
+
+  if (s.events.empty()) {
+    std::cerr << "no events in " << argv[1] << std::endl;
+    return 1;
+  }
+
+  if (!s.problem_file.empty()) {
+    struct daestruct_input* probe = daestruct_input_read(s.problem_file.c_str());
+    if (!probe) {
+      std::cerr << "cannot read the problem in " << s.problem_file << std::endl;
+      return 1;
+    }
+    daestruct_input_delete(probe);
+  }
+
+  const int repetitions = argc > 2 ? std::max(1, atoi(argv[2])) : 1;
+
+  std::ostream out(std::cout.rdbuf());
+  null_buffer null;
+  std::cout.rdbuf(&null);
+
+  latencies lat;
+  size_t singular = 0;
+  for (int r = 0; r < repetitions; r++)
+    singular += replay(s, keep_duals, lat);
+
+  std::cout.rdbuf(out.rdbuf());
+
+  out << "Replayed " << s.events.size() << " events " << repetitions << " time(s) on ";
+  if (s.problem_file.empty())
+    out << "a problem of dimension " << s.dimension << " (" << s.entries.size() << " nonzeros)" << std::endl;
+  else
+    out << "the problem in " << s.problem_file << std::endl;
+  if (singular > 0)
+    out << singular << " event(s) resulted in a structurally singular problem" << std::endl;
+
+  header(out, "[us]");
+  report(out, "modeling", lat.model, 1e6);
+  report(out, "analysis", lat.analysis, 1e6);
+  report(out, "event", lat.total, 1e6);
+  header(out, "[LAP]");
+  report(out, "searches", lat.augmentations, 1);
+  report(out, "scanned", lat.scanned, 1);
+  return 0;
+}
@@ -4,6 +4,16 @@ set(source_dir src)
 #Path to tests
 set(test_dir test)
 
+#Index and derivative types of sigma_matrix, solution and AnalysisResult.
+# (uint32_t, int16_t) or (uint32_t, int8_t) roughly halve the memory per nonzero
+set(DAESTRUCT_INDEX_TYPE "size_t" CACHE STRING "index type (size_t or uint32_t)")
+set(DAESTRUCT_DER_TYPE "int" CACHE STRING "derivative order type (int, int16_t or int8_t)")
+
+add_definitions(
+  -DDAESTRUCT_INDEX_TYPE=${DAESTRUCT_INDEX_TYPE}
+  -DDAESTRUCT_DER_TYPE=${DAESTRUCT_DER_TYPE}
+)
+
 set ( CMAKE_CXX_FLAGS "-std=c++11" )
 set ( CMAKE_C_FLAGS   "-std=c99"   )
 add_definitions(
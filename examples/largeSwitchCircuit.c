@@ -32,6 +32,8 @@ int main(int argc, char** argv) {
 
     const int sw = atoi(argv[2]);
     const int times = atoi(argv[3]);
+    /* optional: remember the results of that many structures */
+    const int cached = argc > 4 ? atoi(argv[4]) : 0;
 
     struct circuit circuit;
     struct daestruct_input* sigma = daestruct_input_create(dimension);    
@@ -46,6 +48,7 @@ int main(int argc, char** argv) {
       struct daestruct_timer* analyse = daestruct_timer_new();
       daestruct_timer_stop(model);
       daestruct_timer_stop(analyse);
+      struct daestruct_cache* cache = cached > 0 ? daestruct_cache_new(cached) : NULL;
       
       daestruct_timer_resume(model);
       struct switch_event se = switch_sub_circuit(&circuit, sw);
@@ -56,7 +59,7 @@ int main(int argc, char** argv) {
 	daestruct_result_delete(result);
 
 	daestruct_timer_resume(analyse);
-	result = daestruct_changed_analyse(ch);
+	result = cache ? daestruct_changed_analyse_cached(ch, cache) : daestruct_changed_analyse(ch);
 	daestruct_timer_stop(analyse);
 
 	daestruct_timer_resume(model);
@@ -81,6 +84,11 @@ int main(int argc, char** argv) {
       daestruct_timer_report(analyse);
       printf("Time spent in modeling:\n");
       daestruct_timer_report(model);
+
+      if (cache) {
+	printf("Cache hits: %d, misses: %d\n", daestruct_cache_hits(cache), daestruct_cache_misses(cache));
+	daestruct_cache_delete(cache);
+      }
       
 
       daestruct_timer_delete(analyse);
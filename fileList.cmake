@@ -3,6 +3,7 @@ set(hdrs_dir ${${PROJECT_NAME}_include_dir})
 set(tests_dir ${CMAKE_CURRENT_SOURCE_DIR}/${test_dir})
 set(srcs_dir ${CMAKE_CURRENT_SOURCE_DIR}/${source_dir})
 set(examples_dir ${CMAKE_CURRENT_SOURCE_DIR}/examples)
+set(bench_dir ${CMAKE_CURRENT_SOURCE_DIR}/bench)
 
 #Project header files
 set(hdrs ${hdrs_dir}/daestruct.hpp)
@@ -10,6 +11,14 @@ set(hdrs ${hdrs_dir}/daestruct.hpp)
 #Project source files
 set(srcs ${srcs_dir}/analysis.cpp 
          ${srcs_dir}/lap.cpp
+         ${srcs_dir}/lap_cost_scaling.cpp
+         ${srcs_dir}/row_kernels.cpp
+         ${srcs_dir}/analysis_cache.cpp
+         ${srcs_dir}/speculation.cpp
+         ${srcs_dir}/streaming_builder.cpp
+         ${srcs_dir}/mapped_sigma_matrix.cpp
+         ${srcs_dir}/matrix_market.cpp
+         ${srcs_dir}/reduced_system.cpp
          ${srcs_dir}/daestruct.cpp
          ${srcs_dir}/timer.cpp
          ${srcs_dir}/variable_analysis.cpp
@@ -31,10 +40,20 @@ set(switchableCircuit_example_sources ${examples_dir}/largeSwitchCircuit.c)
 set(largeCompressedCircuit_example_sources ${examples_dir}/largeCompressedCircuit.c ${examples_dir}/compressed_circuit.c)
 
 
+#benchmarks
+set(bench_sources ${bench_dir}/benchmark.cpp ${bench_dir}/generators.cpp)
+set(replay_sources ${bench_dir}/replay.cpp)
+
 #Public API
 set(${PROJECT_NAME}_headers ${hdrs_dir}/daestruct.h
 			    ${hdrs_dir}/daestruct.hpp
                             ${hdrs_dir}/daestruct/analysis.hpp
+                            ${hdrs_dir}/daestruct/analysis_cache.hpp
+                            ${hdrs_dir}/daestruct/speculation.hpp
+                            ${hdrs_dir}/daestruct/streaming_builder.hpp
+                            ${hdrs_dir}/daestruct/mapped_sigma_matrix.hpp
+                            ${hdrs_dir}/daestruct/matrix_market.hpp
+                            ${hdrs_dir}/daestruct/reduced_system.hpp
 			    ${hdrs_dir}/daestruct/sigma_matrix.hpp
 			    ${hdrs_dir}/daestruct/timer.h
 			    ${hdrs_dir}/daestruct/variable_analysis.hpp
@@ -50,6 +50,42 @@ extern "C" {
    */
   struct daestruct_input* daestruct_input_builder_build(struct daestruct_input_builder* problem);
 
+  /* builder that keeps only a bounded number of entries in memory */
+  struct daestruct_input_stream;
+
+  /**
+   * create a streaming input problem builder for the structural analysis
+   * At most @chunk_entries entries are kept in memory, larger problems are 
+   * sorted in chunks on temporary files (@chunk_entries <= 0 uses a default)
+   * the returned pointer must be deleted with daestruct_input_stream_delete
+   */
+  struct daestruct_input_stream* daestruct_input_stream_create(int dimension, int chunk_entries);
+
+  /**
+   * set the maximum derivative of @variable in @equation, entries may come in any order
+   * if an entry is given more than once, the highest derivative is kept
+   * returns 0, or -1 if @variable or @equation is out of range (the entry is ignored)
+   */
+  int daestruct_input_stream_append(struct daestruct_input_stream* stream, int variable, int equation, int derivative);
+
+  /**
+   * append @count entries at once
+   * returns 0, or -1 if an entry is out of range (it and all following entries are ignored)
+   */
+  int daestruct_input_stream_append_chunk(struct daestruct_input_stream* stream, int count,
+					  const int* variables, const int* equations, const int* derivatives);
+
+  /**
+   * create an input problem description from the stream, the stream is empty afterwards
+   * the returned pointer must be deleted with daestruct_input_delete
+   */
+  struct daestruct_input* daestruct_input_stream_build(struct daestruct_input_stream* stream);
+
+  /**
+   * delete a streaming input problem builder
+   */
+  void daestruct_input_stream_delete(struct daestruct_input_stream* stream);
+
   /**
    * set the maximum derivative of @variable in @equation in the given input problem
    */
@@ -81,15 +117,107 @@ extern "C" {
    */
   void daestruct_input_delete(struct daestruct_input* problem);
 
+  /* options of the structural analysis */
+  enum daestruct_option {
+    /* keep the LAP duals in the result to warm-start changed problems with them (default: 0) */
+    DAESTRUCT_KEEP_DUALS = 0,
+    /* threads of the fixed-point iteration, 0 for as many as there are cores and it is worth it (default: 0) */
+    DAESTRUCT_THREADS = 1,
+    /* offsets by sweeps until a fixed point (0, default) or from the duals of the LAP (1) */
+    DAESTRUCT_OFFSETS = 2,
+    /* the LAP by shortest augmenting paths (0, default) or by cost scaling (1) */
+    DAESTRUCT_ENGINE = 3
+  };
+
+  /**
+   * set an option (see enum daestruct_option) for the analysis of @problem
+   * problems derived from @problem (see daestruct_change_orig()) inherit it
+   */
+  void daestruct_input_set_option(struct daestruct_input* problem, int option, int value);
+
   /* daestruct invocation */
   struct daestruct_result;
 
   /**
    * actually run the structural analysis
    * the returned pointer must be deleted with daestruct_result_delete()
+   * returns NULL if the analysis fails (e.g. its fixed point does not converge)
    */
   struct daestruct_result* daestruct_analyse(struct daestruct_input* problem);
 
+  /* input problem whose incidence matrix is a memory-mapped file */
+  struct daestruct_mapped;
+
+  /**
+   * write the incidence matrix of @problem to a file for daestruct_mapped_open
+   * returns 0 on success
+   */
+  int daestruct_input_write_mapped(struct daestruct_input* problem, const char* path);
+
+  /**
+   * write all entries of @stream to a file for daestruct_mapped_open, the stream is empty afterwards
+   * the problem is never held in memory completely
+   * returns 0 on success
+   */
+  int daestruct_input_stream_write_mapped(struct daestruct_input_stream* stream, const char* path);
+
+  /**
+   * map an incidence matrix file, the matrix is read from disk on demand during the analysis
+   * returns NULL if the file cannot be mapped or has not been written by this build
+   * the returned pointer must be deleted with daestruct_mapped_delete
+   */
+  struct daestruct_mapped* daestruct_mapped_open(const char* path);
+
+  /**
+   * run the structural analysis on a mapped problem
+   * the returned pointer must be deleted with daestruct_result_delete()
+   * returns NULL if the analysis fails
+   */
+  struct daestruct_result* daestruct_mapped_analyse(struct daestruct_mapped* problem);
+
+  /**
+   * unmap a mapped input problem
+   */
+  void daestruct_mapped_delete(struct daestruct_mapped* problem);
+
+  /**
+   * read an input problem from a Matrix Market coordinate file (1-based 
+   * <equation> <variable> <derivative> entries) or from a file written 
+   * by daestruct_input_write_mapped, the text is parsed on all cores
+   * returns NULL if the file cannot be read or is malformed
+   * the returned pointer must be deleted with daestruct_input_delete
+   */
+  struct daestruct_input* daestruct_input_read(const char* path);
+
+  /**
+   * write the incidence matrix of @problem as a Matrix Market file
+   * returns 0 on success
+   */
+  int daestruct_input_write(struct daestruct_input* problem, const char* path);
+
+  /* outcome of a structural analysis */
+  enum daestruct_status {
+    /* the derivation indices are valid */
+    DAESTRUCT_OK = 0,
+    /* the problem has no complete assignment, the derivation indices are meaningless */
+    DAESTRUCT_STRUCTURALLY_SINGULAR = 1
+  };
+
+  /**
+   * get the outcome (see enum daestruct_status) of the analysis
+   */
+  int daestruct_result_status(struct daestruct_result* result);
+
+  /**
+   * get the number of shortest augmenting path searches the LAP needed
+   */
+  int daestruct_result_augmentations(struct daestruct_result* result);
+
+  /**
+   * get the number of columns scanned by all shortest augmenting path searches
+   */
+  int daestruct_result_scanned_columns(struct daestruct_result* result);
+
   /**
    * get the derivation index
    */
@@ -100,11 +228,177 @@ extern "C" {
    */
   int daestruct_result_variable_index(struct daestruct_result* result, int variable);
 
+  /**
+   * get the number of equations (and variables) covered by the given result
+   * this includes the equations and variables of inflated components
+   */
+  int daestruct_result_dimension(struct daestruct_result* result);
+
+  /**
+   * get a read-only pointer to all equation derivation indices
+   * the pointer stays valid until the result is deleted
+   */
+  const int* daestruct_result_equation_indices(struct daestruct_result* result);
+
+  /**
+   * get a read-only pointer to all variable derivation indices
+   * the pointer stays valid until the result is deleted
+   */
+  const int* daestruct_result_variable_indices(struct daestruct_result* result);
+
+  /**
+   * copy all equation derivation indices into @dst
+   * @dst must have room for daestruct_result_dimension() elements
+   */
+  void daestruct_result_copy_equation_indices(struct daestruct_result* result, int* dst);
+
+  /**
+   * copy all variable derivation indices into @dst
+   * @dst must have room for daestruct_result_dimension() elements
+   */
+  void daestruct_result_copy_variable_indices(struct daestruct_result* result, int* dst);
+
+  /**
+   * copy the variable assigned to each equation into @dst
+   * @dst must have room for daestruct_result_dimension() elements
+   */
+  void daestruct_result_copy_row_assignment(struct daestruct_result* result, int* dst);
+
+  /**
+   * copy the equation assigned to each variable into @dst
+   * @dst must have room for daestruct_result_dimension() elements
+   */
+  void daestruct_result_copy_col_assignment(struct daestruct_result* result, int* dst);
+
+  /**
+   * get the number of inflated component instances in the given result
+   */
+  int daestruct_result_components(struct daestruct_result* result);
+
+  /**
+   * copy the offsets of the first equation (@rows) and first private variable (@cols)
+   * of every inflated component instance
+   * both arrays must have room for daestruct_result_components() elements
+   */
+  void daestruct_result_copy_component_offsets(struct daestruct_result* result, int* rows, int* cols);
+
   /**
    * delete the given result description
    */
   void daestruct_result_delete(struct daestruct_result* result);  
 
+  /**
+   * write the offsets and the assignment of @result as a Matrix Market array 
+   * with the columns c, d and the (1-based) variable assigned to each equation
+   * returns 0 on success
+   */
+  int daestruct_result_write(struct daestruct_result* result, const char* path);
+
+  /* structure of the index-reduced (differentiated) system */
+  struct daestruct_reduced;
+
+  /**
+   * build the index-reduced system of @problem from its analysis @result
+   * returns NULL if the result is not DAESTRUCT_OK or does not belong to @problem
+   * the returned pointer must be deleted with daestruct_reduced_delete
+   */
+  struct daestruct_reduced* daestruct_reduce(struct daestruct_input* problem, struct daestruct_result* result);
+
+  /**
+   * number of differentiated equations, i.e. the sum of (c_i + 1)
+   * equation i differentiated k times is equation_start[i] + k
+   */
+  int daestruct_reduced_equations(struct daestruct_reduced* reduced);
+
+  /**
+   * number of derivatives, i.e. the sum of (d_j + 1)
+   * the k-th derivative of variable j is variable_start[j] + k
+   */
+  int daestruct_reduced_variables(struct daestruct_reduced* reduced);
+
+  /**
+   * copy the first differentiated equation and the first derivative of every equation and variable
+   * both arrays must have room for dimension + 1 elements
+   */
+  void daestruct_reduced_copy_starts(struct daestruct_reduced* reduced, int* equation_start, int* variable_start);
+
+  /**
+   * number of entries in the incidence of the differentiated system
+   */
+  int daestruct_reduced_nonzeros(struct daestruct_reduced* reduced);
+
+  /**
+   * copy the incidence of the differentiated system in compressed row form
+   * @row_start needs room for daestruct_reduced_equations() + 1 elements,
+   * @columns for daestruct_reduced_nonzeros() elements
+   */
+  void daestruct_reduced_copy_incidence(struct daestruct_reduced* reduced, int* row_start, int* columns);
+
+  /**
+   * number of blocks in the block triangular form of the highest-derivative Jacobian
+   */
+  int daestruct_reduced_blocks(struct daestruct_reduced* reduced);
+
+  /**
+   * copy the block triangular form, block b consists of the equations 
+   * equations[block_start[b] .. block_start[b+1]) and only depends on earlier blocks
+   * @block_start needs room for daestruct_reduced_blocks() + 1 elements, @equations for dimension elements
+   */
+  void daestruct_reduced_copy_blocks(struct daestruct_reduced* reduced, int* block_start, int* equations);
+
+  /**
+   * number of dummy derivative candidates, i.e. the sum of c_i
+   */
+  int daestruct_reduced_dummies(struct daestruct_reduced* reduced);
+
+  /**
+   * number of states, i.e. the derivatives below d_j that are no dummy derivatives
+   */
+  int daestruct_reduced_degrees_of_freedom(struct daestruct_reduced* reduced);
+
+  /**
+   * copy the dummy derivative candidates, the n-th one is derivative @orders[n] of @variables[n]
+   * both arrays must have room for daestruct_reduced_dummies() elements
+   */
+  void daestruct_reduced_copy_dummies(struct daestruct_reduced* reduced, int* variables, int* orders);
+
+  /**
+   * delete an index-reduced system
+   */
+  void daestruct_reduced_delete(struct daestruct_reduced* reduced);
+
+  /* bounded cache of analysis results, keyed by the structure of the problem */
+  struct daestruct_cache;
+
+  /**
+   * create a cache holding at most @capacity results
+   * the returned pointer must be deleted with daestruct_cache_delete()
+   */
+  struct daestruct_cache* daestruct_cache_new(int capacity);
+
+  /**
+   * delete the given cache
+   */
+  void daestruct_cache_delete(struct daestruct_cache* cache);
+
+  /**
+   * number of analyses answered by the given cache
+   */
+  int daestruct_cache_hits(struct daestruct_cache* cache);
+
+  /**
+   * number of analyses the given cache could not answer
+   */
+  int daestruct_cache_misses(struct daestruct_cache* cache);
+
+  /**
+   * like daestruct_analyse(), but returns a copy of the cached result if
+   * a problem with the same structure has been analysed using @cache before
+   * the returned pointer must be deleted with daestruct_result_delete()
+   * returns NULL if the analysis fails
+   */
+  struct daestruct_result* daestruct_analyse_cached(struct daestruct_input* problem, struct daestruct_cache* cache);
+
   struct daestruct_component_builder;
 
   /**
@@ -172,6 +466,7 @@ extern "C" {
   /**
    * run the structural analysis using a list of compressed components
    * the returned pointer must be deleted with daestruct_result_delete()
+   * returns NULL if the analysis fails
    */
   struct daestruct_result* daestruct_analyse_compressed(struct daestruct_input* problem, struct daestruct_component_list* list);
 
@@ -19,6 +19,8 @@
 #ifndef DAE_ANALYSIS_HPP
 #define DAE_ANALYSIS_HPP
 
+#include <algorithm>
+#include <atomic>
 #include <vector>
 #include <functional>
 #include <boost/variant.hpp>
@@ -26,12 +28,47 @@
 #include <daestruct/sigma_matrix.hpp>
 
 namespace daestruct {
+  class mapped_sigma_matrix;
+
   namespace analysis {
 
     using namespace std;
 
-    void solveByFixedPoint(const std::vector<size_t>& assignment,  
+    class AnalysisCache;
+
+    /**
+     * The smallest offsets c, d for the given (optimal) assignment, starting from c = d = 0
+     * With threads > 1 the sweeps are split over that many threads (0: as many as there 
+     * are cores and it is worth it), the offsets are the same as with a single thread.
+     * The threads work on a column index of sigma, which takes about as much memory as sigma.
+     * Throws std::invalid_argument if an equation is assigned to a variable it does not depend 
+     * on or the iteration does not converge (the assignment is not optimal).
+     * Once *cancel is set the sweeps stop, leaving c and d meaningless.
+     */
+    void solveByFixedPoint(const std::vector<index_t>& assignment,  
+			   const sigma_matrix& sigma,
+			   std::vector<int>& c, std::vector<int>& d, unsigned threads = 1,
+			   const std::atomic<bool>* cancel = nullptr);
+
+    void solveByFixedPoint(const std::vector<index_t>& assignment,  
+			   const mapped_sigma_matrix& sigma,
+			   std::vector<int>& c, std::vector<int>& d, unsigned threads = 1,
+			   const std::atomic<bool>* cancel = nullptr);
+
+    /**
+     * The smallest offsets c, d for the given assignment from the duals u, v of the LAP that
+     * found it, the same as solveByFixedPoint() but in O(nonzeros * log(dimension)) instead of 
+     * O(nonzeros) per sweep. Throws std::invalid_argument if u, v are not feasible duals that 
+     * are tight on the assignment (i.e. do not prove it optimal).
+     */
+    void solveByPotentials(const std::vector<index_t>& assignment,  
 			   const sigma_matrix& sigma,
+			   const std::vector<int>& u, const std::vector<int>& v,
+			   std::vector<int>& c, std::vector<int>& d);
+
+    void solveByPotentials(const std::vector<index_t>& assignment,  
+			   const mapped_sigma_matrix& sigma,
+			   const std::vector<int>& u, const std::vector<int>& v,
 			   std::vector<int>& c, std::vector<int>& d);
 
     struct InflatedMap {
@@ -44,13 +81,74 @@ namespace daestruct {
       std::vector<int> component_rows;
     };
 
+    enum AnalysisStatus {
+      /* c and d are the canonical offsets */
+      ANALYSIS_OK = 0,
+      /* there is no complete assignment, c and d are meaningless */
+      ANALYSIS_STRUCTURALLY_SINGULAR = 1,
+      /* AnalysisOptions::cancel was set before the analysis finished, nothing is meaningful */
+      ANALYSIS_CANCELLED = 2
+    };
+
+    /* how the offsets are calculated from the optimal assignment */
+    enum OffsetMethod {
+      /* sweeps from c = d = 0 until nothing changes, see solveByFixedPoint() */
+      OFFSETS_FIXED_POINT = 0,
+      /* a single shortest path search with the duals of the LAP, see solveByPotentials() */
+      OFFSETS_POTENTIALS = 1
+    };
+
+    /* the algorithm for the linear assignment problem */
+    enum AssignmentEngine {
+      /* shortest augmenting paths (Jonker and Volgenant), see lap() */
+      ENGINE_JONKER_VOLGENANT = 0,
+      /* cost scaling (Goldberg and Kennedy), see lap_cost_scaling() */
+      ENGINE_COST_SCALING = 1
+    };
+
+    /**
+     * Options of the structural analysis
+     * A changed problem inherits the options of the problem it has been derived from.
+     */
+    struct AnalysisOptions {
+      /* keep the LAP duals u and v in the result, a changed problem is warm-started with them */
+      bool keep_duals = false;
+
+      /* threads of the fixed-point iteration (0: as many as there are cores and it is worth it), see solveByFixedPoint() */
+      unsigned threads = 0;
+
+      /* compressed problems always use the fixed point, there are no duals of the inflated problem */
+      OffsetMethod offsets = OFFSETS_FIXED_POINT;
+
+      /* changes are warm-started and compressed problems solved by Jonker-Volgenant regardless */
+      AssignmentEngine engine = ENGINE_JONKER_VOLGENANT;
+
+      /* 
+       * once *cancel is set, the LAP and the fixed-point iteration of an uncompressed problem 
+       * stop early and the result is ANALYSIS_CANCELLED (used by Speculation to discard candidates)
+       */
+      const std::atomic<bool>* cancel = nullptr;
+
+      bool cancelled() const { return cancel && *cancel; }
+    };
+
     struct AnalysisResult {
-      std::vector<size_t> row_assignment;
-      std::vector<size_t> col_assignment;
+      AnalysisStatus status = ANALYSIS_OK;
+
+      std::vector<index_t> row_assignment;
+      std::vector<index_t> col_assignment;
       
       std::vector<int> c;
       std::vector<int> d;
 
+      /* the duals of the LAP, only kept with AnalysisOptions::keep_duals (and never when compressed) */
+      std::vector<int> u;
+      std::vector<int> v;
+
+      /* number of shortest augmenting path searches (bids with cost scaling) of the LAP and of the columns they scanned */
+      size_t augmentations = 0;
+      size_t scanned_columns = 0;
+
       InflatedMap inflated;
 
       int extracted_equation(int eq, int k) const ;
@@ -70,15 +168,20 @@ namespace daestruct {
 
       sigma_matrix sigma; //represents D and d as well
 
-      typedef std::vector<std::vector<size_t>> assignment_permutations;
+      /* M_0 .. M_{q-1} in the form of row-assignments, p+1 rows each */
+      std::vector<index_t> M;
 
-      /* M_q in the form of row-assignments */
-      assignment_permutations M;
+      /* the row-assignment M_j */
+      const index_t* assignment(size_t j) const { return M.data() + j * (p + 1); }
 
       /* cost of the M_q assignments */
       std::vector<int> cost;
 
-      compressible(int pub_v, int pri_v, const sigma_matrix& s);
+      /* whether M_q exists at all, i.e. the component can leave q to the outside */
+      std::vector<bool> feasible;
+
+      /* the rows are filled in by compressible_builder::build() */
+      compressible(int pub_v, int pri_v);
 
     };
 
@@ -89,11 +192,17 @@ namespace daestruct {
       size_t p;
       size_t q;
 
-      //TODO: replace this with a better suited matrix, 
-      //every row from p+1 .. p+q will be full in the end
-      sigma_matrix sigma; //represents D and d as well
+      /* 
+       * The p+1 equations bordered by one public variable: column 0 is the public variable
+       * of the current M_q, columns 1 .. p are the private variables. The other public 
+       * variables are left to the outside, so there are no rows for them.
+       */
+      sigma_matrix sigma;
 
-      compressible_builder(int pub_v, int pri_v) : p(pri_v), q(pub_v), sigma(p+q) {}
+      /* the incidences of the public variables, a row per public variable and a column per equation */
+      sigma_matrix publics;
+
+      compressible_builder(int pub_v, int pri_v) : p(pri_v), q(pub_v), sigma(p+1), publics(std::max(p+1, q)) {}
 
       /**
        * Build this sub-component (i.e. afterwards set_*_incidence is a no-op)
@@ -134,6 +243,7 @@ namespace daestruct {
     struct InputProblem {
       int dimension;
       sigma_matrix sigma;
+      AnalysisOptions options;
   
       InputProblem(const coordinate_matrix<der_t>& builder) : dimension(builder.size1()), sigma(builder) {}
 
@@ -142,6 +252,11 @@ namespace daestruct {
       InputProblem(int d, int nnzs) : dimension(d), sigma(d, nnzs) {}
 
       AnalysisResult pryceAlgorithm() const;
+
+      /**
+       * pryceAlgorithm() answered from (and stored in) the given cache
+       */
+      AnalysisResult pryceAlgorithm(AnalysisCache& cache) const;
     
       AnalysisResult pryceCompressed(const compression& c) const;
     };
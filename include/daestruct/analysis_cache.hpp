@@ -0,0 +1,100 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DAE_ANALYSIS_CACHE_HPP
+#define DAE_ANALYSIS_CACHE_HPP
+
+#include <list>
+#include <unordered_map>
+
+#include <daestruct/sigma_matrix.hpp>
+#include <daestruct/analysis.hpp>
+
+namespace daestruct {
+  namespace analysis {
+
+    /**
+     * A bounded cache of analysis results keyed by the structure (i.e. the 
+     * sigma matrix) they belong to. Switchable systems usually cycle through 
+     * a few modes, so a structure that has been analysed before is likely to 
+     * come up again.
+     * The key is the dimension and the fingerprint of the sigma matrix and the
+     * options that change the result (whether it has the duals and which engine 
+     * picked the assignment). Two different structures are only confused on a 
+     * 64 bit hash collision.
+     * A result from the cache has cost no work, i.e. its augmentations and 
+     * scanned_columns are 0.
+     * When full, the least recently used result is evicted.
+     */
+    class AnalysisCache {
+    public:
+      struct key {
+	size_t dimension;
+	uint64_t fingerprint;
+	bool keep_duals;
+	AssignmentEngine engine;
+
+	bool operator==(const key& other) const {
+	  return dimension == other.dimension && fingerprint == other.fingerprint &&
+	    keep_duals == other.keep_duals && engine == other.engine;
+	}
+      };
+
+      struct key_hash {
+	size_t operator()(const key& k) const {
+	  return sigma_matrix::mix(k.fingerprint ^ k.dimension ^ (uint64_t(k.keep_duals) << 32) ^ (uint64_t(k.engine) << 33));
+	}
+      };
+
+    private:
+      typedef std::list<std::pair<key, AnalysisResult>> lru_list;
+
+      size_t capacity;
+      /* most recently used first */
+      lru_list results;
+      std::unordered_map<key, lru_list::iterator, key_hash> index;
+
+    public:
+      size_t hits = 0;
+      size_t misses = 0;
+
+      AnalysisCache(size_t cap) : capacity(cap) {}
+
+      static key key_of(const sigma_matrix& sigma, const AnalysisOptions& options) {
+	return key { sigma.dimension(), sigma.fingerprint(), options.keep_duals, options.engine };
+      }
+
+      /**
+       * The stored result for the given structure or nullptr
+       * The pointer stays valid until the next call to store()
+       */
+      const AnalysisResult* lookup(const sigma_matrix& sigma, const AnalysisOptions& options);
+
+      /**
+       * Remember the result of the analysis of the given structure
+       * Only results of uncompressed problems may be stored, as the key does 
+       * not cover the compressed components. Cancelled results are not stored.
+       */
+      void store(const sigma_matrix& sigma, const AnalysisOptions& options, const AnalysisResult& result);
+
+      size_t size() const { return results.size(); }
+    };
+  }
+}
+
+#endif
@@ -23,6 +23,11 @@
 
 #include <daestruct/analysis.hpp>
 #include <daestruct/variable_analysis.hpp>
+#include <daestruct/analysis_cache.hpp>
+#include <daestruct/speculation.hpp>
+#include <daestruct/streaming_builder.hpp>
+#include <daestruct/mapped_sigma_matrix.hpp>
+#include <daestruct/reduced_system.hpp>
 
 using namespace daestruct::analysis;
 using namespace boost::numeric::ublas;
@@ -31,8 +36,20 @@ struct daestruct_input_builder : public coordinate_matrix<daestruct::der_t> {};
 
 struct daestruct_input : public InputProblem {};
 
+struct daestruct_input_stream : public streaming_builder {
+  daestruct_input_stream(size_t dimension, size_t chunk_entries) : streaming_builder(dimension, chunk_entries) {}
+};
+
+struct daestruct_mapped : public MappedProblem {
+  daestruct_mapped(const std::string& path) : MappedProblem(path) {}
+};
+
 struct daestruct_result : public AnalysisResult {};
 
+struct daestruct_reduced : public ReducedSystem {
+  daestruct_reduced(ReducedSystem&& r) : ReducedSystem(std::move(r)) {}
+};
+
 struct daestruct_diff : public StructChange {};
 
 struct daestruct_changed : public ChangedProblem {};
@@ -45,4 +62,13 @@ struct daestruct_component_list : public compression {};
 
 struct daestruct_component_instance : public compressible_instance {};
 
+struct daestruct_cache : public AnalysisCache {
+  daestruct_cache(size_t capacity) : AnalysisCache(capacity) {}
+};
+
+struct daestruct_speculation : public Speculation {
+  daestruct_speculation(const InputProblem& base, const AnalysisResult& res) : Speculation(base, res) {}
+  daestruct_speculation(const ChangedProblem& base, const AnalysisResult& res) : Speculation(base, res) {}
+};
+
 #endif
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DAESTRUCT_MAPPED_SIGMA_MATRIX_HPP
+#define DAESTRUCT_MAPPED_SIGMA_MATRIX_HPP
+
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+#include <daestruct/sigma_matrix.hpp>
+#include <daestruct/analysis.hpp>
+
+namespace daestruct {
+
+  /**
+   * A read-only sigma matrix in a memory-mapped file, for problems that do
+   * not fit into memory next to the simulator. Only the pages that are 
+   * touched are loaded, and the kernel is free to drop them again.
+   *
+   * The file is a CSR (compressed sparse row) layout:
+   *   header
+   *   row_start[dimension + 1]  (uint64_t, offsets into entries)
+   *   minimum_row[dimension]    (index_t)
+   *   entries[nonzeros]         ({index_t column, der_t cost}, sorted by column within a row)
+   * Column index and cost are stored next to each other, since every row scan reads both.
+   * The file is only valid on machines with the same index_t, der_t and byte order.
+   */
+  class mapped_sigma_matrix {
+  public:
+    struct header {
+      char magic[8];
+      uint32_t version;
+      uint32_t index_size;
+      uint32_t der_size;
+      uint32_t reserved;
+      uint64_t dimension;
+      uint64_t nonzeros;
+      uint64_t fingerprint;
+    };
+
+    struct entry {
+      index_t column;
+      der_t cost;
+    };
+
+    static const uint32_t version = 1;
+
+    /**
+     * A row of a mapped matrix, iterated like a row of a sigma_matrix
+     */
+    class row_t {
+      const entry* first;
+      const entry* last;
+
+    public:
+      class const_iterator {
+	const entry* e;
+      public:
+	const_iterator(const entry* p) : e(p) {}
+
+	size_t index() const { return e->column; }
+	const der_t& operator*() const { return e->cost; }
+
+	const_iterator& operator++() { ++e; return *this; }
+	const_iterator operator++(int) { const_iterator old(*this); ++e; return old; }
+
+	bool operator==(const const_iterator& other) const { return e == other.e; }
+	bool operator!=(const const_iterator& other) const { return e != other.e; }
+      };
+
+      row_t(const entry* f, const entry* l) : first(f), last(l) {}
+
+      const_iterator begin() const { return const_iterator(first); }
+      const_iterator end() const { return const_iterator(last); }
+
+      size_t nnz() const { return last - first; }
+
+      const entry* data() const { return first; }
+
+      /* binary search, the entries are sorted by column */
+      const der_t* find_element(size_t j) const;
+    };
+
+    /* access pattern hints for the whole mapping, see madvise(2) */
+    enum access {
+      ACCESS_NORMAL,
+      ACCESS_SEQUENTIAL,
+      ACCESS_RANDOM,
+      ACCESS_WILLNEED
+    };
+
+    /**
+     * Writes a mapped matrix file from entries given in row-major order,
+     * i.e. like sigma_matrix::push_back on increasing rows and, within a row,
+     * strictly increasing columns (std::runtime_error otherwise).
+     * Only the per-row and per-column vectors are kept in memory,
+     * the entries go straight to the file.
+     */
+    class writer {
+      std::FILE* file;
+      size_t dimension;
+      std::vector<uint64_t> row_start;
+      std::vector<index_t> minimum_row;
+      std::vector<der_t> minimum;
+      std::vector<bool> seen;
+      size_t current_row = 0;
+      /* the smallest column the current row can continue with */
+      size_t next_column = 0;
+      uint64_t nonzeros = 0;
+      uint64_t fingerprint = 0;
+
+    public:
+      writer(const std::string& path, size_t dim);
+
+      ~writer();
+
+      writer(const writer&) = delete;
+      writer& operator=(const writer&) = delete;
+
+      void push_back(size_t i, size_t j, der_t x);
+
+      /**
+       * write the row and column vectors, the file can be mapped afterwards
+       */
+      void close();
+    };
+
+  private:
+    boost::interprocess::file_mapping file;
+    /* mutable for advise() */
+    mutable boost::interprocess::mapped_region region;
+
+    const header* head;
+    const uint64_t* row_start;
+    const index_t* minimum_row;
+    const entry* entries;
+
+  public:
+    /**
+     * map the given file, throws std::runtime_error if it is not a matrix file of this build
+     */
+    explicit mapped_sigma_matrix(const std::string& path);
+
+    /**
+     * write the given matrix into a file that can be mapped
+     */
+    static void write(const sigma_matrix& sigma, const std::string& path);
+
+    /* whether the given file contents start like a mapped matrix file */
+    static bool is_mapped_file(const char* data, size_t size);
+
+    /* offset of the entries in a file of the given dimension */
+    static size_t entries_offset(size_t dimension);
+
+    size_t dimension() const { return head->dimension; }
+
+    size_t nonzeros() const { return head->nonzeros; }
+
+    uint64_t fingerprint() const { return head->fingerprint; }
+
+    row_t row(size_t i) const {
+      return row_t(entries + row_start[i], entries + row_start[i + 1]);
+    }
+
+    index_t smallest_cost_row(size_t column) const {
+      return minimum_row[column];
+    }
+
+    const der_t* find_element(size_t i, size_t j) const {
+      return row(i).find_element(j);
+    }
+
+    const int operator()(const size_t i, const size_t j) const {
+      const der_t* ptr = find_element(i, j);
+      if (ptr)
+	return *ptr;
+      else
+	return BIG;
+    }
+
+    /**
+     * Hint the expected access pattern to the kernel. Row scans (e.g. the 
+     * fixed point) are sequential, augmenting path searches jump around.
+     */
+    void advise(access pattern) const;
+  };
+
+  namespace analysis {
+
+    /**
+     * An input problem whose sigma matrix stays on disk
+     * The LAP and the fixed point iterate the mapped rows directly, only the 
+     * per-dimension vectors (assignment, duals, offsets) are held in memory.
+     */
+    struct MappedProblem {
+      mapped_sigma_matrix sigma;
+      AnalysisOptions options;
+
+      explicit MappedProblem(const std::string& path) : sigma(path) {}
+
+      int dimension() const { return sigma.dimension(); }
+
+      AnalysisResult pryceAlgorithm() const;
+    };
+  }
+}
+
+#endif
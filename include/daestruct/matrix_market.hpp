@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DAE_MATRIX_MARKET_HPP
+#define DAE_MATRIX_MARKET_HPP
+
+#include <ostream>
+#include <string>
+
+#include <daestruct/sigma_matrix.hpp>
+#include <daestruct/analysis.hpp>
+
+namespace daestruct {
+  namespace analysis {
+
+    /**
+     * Import and export of structures, e.g. to capture them from production 
+     * runs and replay them in benchmarks and bug reports.
+     *
+     * The text format is a Matrix Market coordinate file:
+     *   %%MatrixMarket matrix coordinate integer general
+     *   % comments
+     *   <equations> <variables> <entries>
+     *   <equation> <variable> <derivative>     (1-based, one entry per line)
+     * "pattern" files (without values) are read with derivative 0.
+     * Entries may come in any order, duplicates keep the highest derivative.
+     *
+     * The binary format is the file of a mapped_sigma_matrix.
+     * All readers throw std::runtime_error on malformed input.
+     */
+
+    /**
+     * Parse a Matrix Market file in memory, the entries are parsed on the given 
+     * number of threads (0: as many as there are cores and it is worth it)
+     */
+    InputProblem parse_matrix_market(const char* begin, const char* end, unsigned threads = 0);
+
+    /**
+     * Read a problem from a Matrix Market or a binary (mapped_sigma_matrix) file
+     */
+    InputProblem read_problem(const std::string& path, unsigned threads = 0);
+
+    /**
+     * Write the structure as a Matrix Market file
+     * Works for the sigma matrix of an InputProblem as well as of a ChangedProblem.
+     */
+    void write_matrix_market(const sigma_matrix& sigma, std::ostream& out);
+
+    /**
+     * Write the offsets and the assignment of a result as a Matrix Market array
+     * with the three columns c, d and the (1-based) variable assigned to each 
+     * equation (0 if unassigned)
+     */
+    void write_matrix_market(const AnalysisResult& result, std::ostream& out);
+  }
+}
+
+#endif
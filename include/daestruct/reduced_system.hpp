@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DAE_REDUCED_SYSTEM_HPP
+#define DAE_REDUCED_SYSTEM_HPP
+
+#include <vector>
+
+#include <daestruct/sigma_matrix.hpp>
+#include <daestruct/analysis.hpp>
+
+namespace daestruct {
+  namespace analysis {
+
+    /**
+     * Structure of the index-reduced system, i.e. every equation i differentiated 
+     * c_i times, as the next step after the offsets.
+     *
+     * Differentiated equation f_i^(k) (k = 0 .. c_i) is row equation_start[i] + k,
+     * derivative x_j^(k) (k = 0 .. d_j) is column variable_start[j] + k.
+     * Each differentiated equation lists the highest derivative of every variable 
+     * it contains, f_i^(k) contains x_j^(sigma_ij + k).
+     */
+    struct ReducedSystem {
+      std::vector<index_t> equation_start;
+      std::vector<index_t> variable_start;
+
+      /* incidence of the differentiated system (compressed rows) */
+      std::vector<index_t> row_start;
+      std::vector<index_t> columns;
+
+      /**
+       * Block triangular form of the highest-derivative (system) Jacobian
+       * Block b consists of the equations block_equations[block_start[b] .. block_start[b+1]), 
+       * every block only depends on the variables assigned in earlier blocks.
+       */
+      std::vector<index_t> block_start;
+      std::vector<index_t> block_equations;
+
+      /**
+       * Structural dummy derivative candidates (Mattsson-Söderlind) per level
+       * Level l (l = 1 .. max c) consists of the derivatives x_j^(o) with 
+       * j = dummy_variables[n], o = dummy_orders[n] for n in [dummy_start[l-1], dummy_start[l]).
+       * They are chosen along the assignment, any other structurally nonsingular
+       * choice within the same block and level (e.g. after numerical pivoting) is valid as well.
+       */
+      std::vector<index_t> dummy_start;
+      std::vector<index_t> dummy_variables;
+      std::vector<int> dummy_orders;
+
+      size_t equations() const { return equation_start.back(); }
+
+      size_t variables() const { return variable_start.back(); }
+
+      size_t blocks() const { return block_start.size() - 1; }
+
+      size_t levels() const { return dummy_start.size() - 1; }
+
+      /**
+       * number of states, i.e. derivatives x_j^(k) with k < d_j that are no dummy derivatives
+       */
+      size_t degrees_of_freedom() const { return variables() - equations(); }
+    };
+
+    /**
+     * Build the reduced system from the structure and its analysis, the rows of sigma
+     * are read once for the incidence and once for the block triangular form
+     * The result needs to be ANALYSIS_OK and belong to sigma (i.e. not be compressed), 
+     * otherwise std::invalid_argument is thrown.
+     */
+    ReducedSystem reduce(const sigma_matrix& sigma, const AnalysisResult& result);
+  }
+}
+
+#endif
@@ -23,6 +23,9 @@
 
 #include <iostream>
 #include <climits>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
 #include <boost/numeric/ublas/io.hpp>
 #include <boost/numeric/ublas/vector_sparse.hpp>
 #include <boost/numeric/ublas/matrix_sparse.hpp>
@@ -30,6 +33,18 @@
 
 #define BIG (INT_MAX / 2)
 
+/* 
+ * index and derivative types are fixed at build time, 
+ * see DAESTRUCT_INDEX_TYPE and DAESTRUCT_DER_TYPE in cmake/build_config.cmake 
+ */
+#ifndef DAESTRUCT_INDEX_TYPE
+#define DAESTRUCT_INDEX_TYPE size_t
+#endif
+
+#ifndef DAESTRUCT_DER_TYPE
+#define DAESTRUCT_DER_TYPE int
+#endif
+
 namespace std {
   template<class M>
   inline
@@ -42,69 +57,137 @@ namespace daestruct {
   using namespace boost::numeric::ublas;
   using namespace std;
 
-  typedef int der_t;
+  typedef DAESTRUCT_DER_TYPE der_t;
+  typedef DAESTRUCT_INDEX_TYPE index_t;
+
+  static_assert(std::is_signed<der_t>::value, "der_t needs to be a signed type");
+  static_assert(std::is_unsigned<index_t>::value, "index_t needs to be an unsigned type");
+  /* BIG marks unassigned rows and columns */
+  static_assert(sizeof(index_t) >= sizeof(int), "index_t needs to be able to hold BIG");
 
   class sigma_matrix;
   
-  template<class E, class T> inline static void nicePrint(std::basic_ostringstream<E, T>& s, der_t val);
+  template<class E, class T> inline static void nicePrint(std::basic_ostringstream<E, T>& s, int val);
 
+  /**
+   * Rows are shared between copies of a sigma matrix and only copied when 
+   * they are modified (copy-on-write), so only the rows touched after a copy
+   * take up memory of their own. A copy still takes O(dimension) time for the 
+   * row pointers and the column minima, it just does not copy the entries.
+   */
   class sigma_matrix {
   public:
 
-    typedef mapped_vector<der_t, map_array<size_t, der_t>> row_t;
-    std::vector<size_t> minimum_row;
-    std::vector<row_t> _rows;
+    typedef mapped_vector<der_t, map_array<index_t, der_t>> row_t;
+    std::vector<index_t> minimum_row;
+    std::vector<std::shared_ptr<row_t>> _rows;
+    /* sum of the hashes of all entries, see fingerprint() */
+    uint64_t _fingerprint = 0;
 
-    der_t* find_element(size_t i, size_t j) {
-      row_t& row = _rows.at(i);
-      return row.find_element(j);
+    /**
+     * hash of a single entry <i,j> = x
+     */
+    static uint64_t entry_hash(size_t i, size_t j, der_t x) {
+      return mix(mix(mix(i) ^ j) ^ static_cast<uint64_t>(static_cast<int64_t>(x)));
     }
 
-    const der_t* find_element(size_t i, size_t j) const {
-      const row_t& row = _rows.at(i);
-      return row.find_element(j);
+    /* splitmix64 finalizer */
+    static uint64_t mix(uint64_t z) {
+      z += 0x9e3779b97f4a7c15ULL;
+      z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+      return z ^ (z >> 31);
     }
 
-    sigma_matrix(const coordinate_matrix<der_t>& builder) : minimum_row(builder.size1()) {
-      _rows.reserve(builder.size1());
+    /**
+     * the i-th row for modification, copied first if it is shared
+     */
+    row_t& mutable_row(size_t i) {
+      std::shared_ptr<row_t>& row = _rows.at(i);
+      if (row.use_count() > 1)
+	row = copy_row(*row);
+      return *row;
+    }
 
-      for (auto row_iter = builder.begin1(); row_iter != builder.end1(); row_iter++) {
-	row_t row(_rows.size());
-	for (auto col_iter = row_iter.begin(); col_iter != row_iter.end(); col_iter++) {
-	  const size_t i = col_iter.index1();
-	  const size_t j = col_iter.index2();
-	  const der_t x = *col_iter;
+    /*
+     * copy element by element, the copy constructor of map_array (at least 
+     * up to Boost 1.83) copies the uninitialized new storage into the source
+     */
+    static std::shared_ptr<row_t> copy_row(const row_t& row) {
+      std::shared_ptr<row_t> copy = std::make_shared<row_t>(row.size(), row.nnz());
+      for (auto it = row.begin(); it != row.end(); it++)
+	copy->insert_element(it.index(), *it);
+      return copy;
+    }
 
-	  const der_t* m_ptr = find_element(minimum_row[j],j);
-      
-	  if (!m_ptr || *m_ptr > x) {
-	    minimum_row.at(j) = i;
-	  }
-	  row.insert_element(j, x);
-	}
-	_rows.push_back(row);
-      }
+    /* reading never copies a shared row, see mutable_element() for writes */
+    const der_t* find_element(size_t i, size_t j) const {
+      return row(i).find_element(j);
+    }
+
+    /**
+     * the entry <i,j> (if any) for modification in place, its row is copied first if shared
+     * this neither updates the fingerprint nor the column minimum, insert() does
+     */
+    der_t* mutable_element(size_t i, size_t j) {
+      return mutable_row(i).find_element(j);
     }
 
-    sigma_matrix(size_t d) : minimum_row(d) {
-      _rows.reserve(d);
-      for (size_t i = 0; i < d; i++)
-	_rows.push_back(row_t(d));
+    sigma_matrix(const coordinate_matrix<der_t>& builder) : sigma_matrix(builder.size1()) {
+      for (auto row_iter = builder.begin1(); row_iter != builder.end1(); row_iter++)
+	for (auto col_iter = row_iter.begin(); col_iter != row_iter.end(); col_iter++)
+	  push_back(col_iter.index1(), col_iter.index2(), *col_iter);
     }
 
-    sigma_matrix(size_t d, size_t nnzs) : minimum_row(d) {
-      for (size_t i = 0; i < d; i++)
-	_rows.push_back(row_t(d));
+    /* all rows start out as the same empty row */
+    sigma_matrix(size_t d) : minimum_row(d), _rows(d, std::make_shared<row_t>(d)) {}
+
+    sigma_matrix(size_t d, size_t nnzs) : sigma_matrix(d) {}
+
+    const row_t& row(size_t i) const {
+      return *_rows[i];
     }
 
-    const std::vector<row_t>& rows() const {
-      return _rows;
+    /**
+     * let the i-th row be the (shared) row oi of other
+     * the row must be empty and the column indices need to be the same in both matrices
+     */
+    void share_row(size_t i, const sigma_matrix& other, size_t oi) {
+      _rows.at(i) = other._rows.at(oi);
+      const row_t& r = row(i);
+      for (auto it = r.begin(); it != r.end(); it++) {
+	const size_t j = it.index();
+	const der_t* m_ptr = row(minimum_row[j]).find_element(j);
+	if (!m_ptr || *m_ptr > *it)
+	  minimum_row[j] = i;
+	_fingerprint += entry_hash(i, j, *it);
+      }
+    }
+
+    /* no column index, so find the new minimum of a column the hard way */
+    void find_minimum_row(size_t j) {
+      minimum_row[j] = 0;
+      for (size_t i = 0; i < _rows.size(); i++) {
+	const der_t* ptr = row(i).find_element(j);
+	const der_t* m_ptr = row(minimum_row[j]).find_element(j);
+	if (ptr && (!m_ptr || *m_ptr > *ptr))
+	  minimum_row[j] = i;
+      }
     }
 
-    int smallest_cost_row(size_t column) const {
+    index_t smallest_cost_row(size_t column) const {
       return minimum_row[column];
     }    
 
+    /**
+     * An order independent hash of all entries, i.e. equal matrices have equal 
+     * fingerprints regardless of how they were built. It is updated on every
+     * modification, so asking for it is free.
+     */
+    uint64_t fingerprint() const {
+      return _fingerprint;
+    }
+
     const int operator()(const size_t i, const size_t j) const {
       const der_t* ptr = find_element(i,j);
       if (ptr)
@@ -114,38 +197,59 @@ namespace daestruct {
     }
 
     void insert(size_t i, size_t j, der_t x) {
-      der_t* m_ptr = find_element(minimum_row[j],j);
+      const der_t* m_ptr = row(minimum_row[j]).find_element(j);
       
       if (!m_ptr || *m_ptr > x) {
 	minimum_row.at(j) = i;
       }
       
-      row_t& row = _rows.at(i);
+      row_t& row = mutable_row(i);
 
       der_t* ptr = row.find_element(j);
       if (!ptr) {
 	row.insert_element(j,x);
       } else {
+	_fingerprint -= entry_hash(i, j, *ptr);
+	const bool raises_minimum = minimum_row[j] == i && x > *ptr;
 	*ptr = x;
+	if (raises_minimum)
+	  find_minimum_row(j);
       }
+      _fingerprint += entry_hash(i, j, x);
 
       //std::cout << "after setting <" << i << "," << j << "> to " << x << std::endl;
       //std::cout << *this << std::endl;
     }
 
     void push_back(size_t i, size_t j, der_t x) {
-      const der_t* m_ptr = find_element(minimum_row[j],j);
+      const der_t* m_ptr = row(minimum_row[j]).find_element(j);
       
       if (!m_ptr || *m_ptr > x) {
 	minimum_row.at(j) = i;
       }
       
-      _rows.at(i).insert_element(j,x);
+      mutable_row(i).insert_element(j,x);
+      _fingerprint += entry_hash(i, j, x);
+    }
+
+    /**
+     * remove the entry at <i,j> (if any)
+     */
+    void erase(size_t i, size_t j) {
+      const der_t* ptr = row(i).find_element(j);
+      if (!ptr)
+	return;
+
+      _fingerprint -= entry_hash(i, j, *ptr);
+      mutable_row(i).erase_element(j);
+
+      if (minimum_row[j] == i)
+	find_minimum_row(j);
     }
   
     size_t dimension() const { return _rows.size(); }
 
-    template<class E, class T> inline static void nicePrint(std::basic_ostringstream<E, T>& s, der_t val) {
+    template<class E, class T> inline static void nicePrint(std::basic_ostringstream<E, T>& s, int val) {
       if (val == BIG)
 	s << "∞";
       else
@@ -0,0 +1,77 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DAE_SPECULATION_HPP
+#define DAE_SPECULATION_HPP
+
+#include <memory>
+
+#include <daestruct/analysis.hpp>
+#include <daestruct/variable_analysis.hpp>
+
+namespace daestruct {
+  namespace analysis {
+
+    /**
+     * A changed problem together with its analysis
+     */
+    struct SpeculativeResult {
+      std::unique_ptr<ChangedProblem> problem;
+      AnalysisResult result;
+    };
+
+    /**
+     * Speculative analysis of the candidate changes of a problem
+     * Candidates are built and analysed in the order they are added by a pool of 
+     * at most as many threads as there are cores. Committing a candidate waits only 
+     * for that candidate; one that has not been started yet is analysed right away 
+     * on the calling thread. The speculation works on its own copy of the base problem
+     * and its result (the rows of the matrix are shared, see sigma_matrix).
+     * Candidates that are not committed are discarded with the speculation: those not 
+     * started are dropped, the running ones are cancelled (see AnalysisOptions::cancel) 
+     * and the destructor waits until their LAP or fixed-point iteration notices.
+     */
+    class Speculation {
+      struct state;
+      std::unique_ptr<state> shared;
+
+    public:
+      Speculation(const InputProblem& base, const AnalysisResult& res);
+
+      Speculation(const ChangedProblem& base, const AnalysisResult& res);
+
+      Speculation(const Speculation&) = delete;
+      Speculation& operator=(const Speculation&) = delete;
+
+      ~Speculation();
+
+      /**
+       * Start the analysis of the given change, returns the candidate id
+       */
+      size_t add(const StructChange& delta);
+
+      /**
+       * The changed problem and its analysis for the given candidate id
+       * Every candidate can be committed only once.
+       */
+      SpeculativeResult commit(size_t id);
+    };
+  }
+}
+
+#endif
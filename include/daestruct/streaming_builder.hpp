@@ -0,0 +1,118 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef DAE_STREAMING_BUILDER_HPP
+#define DAE_STREAMING_BUILDER_HPP
+
+#include <cstdio>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <daestruct/sigma_matrix.hpp>
+#include <daestruct/analysis.hpp>
+
+namespace daestruct {
+  namespace analysis {
+
+    /**
+     * Builds an InputProblem from entries given in any order with bounded memory
+     * Entries are collected in a chunk of fixed size. A full chunk is sorted, 
+     * deduplicated and written to a temporary file as a sorted run. build() merges 
+     * all runs directly into the sigma matrix, so there is never a complete 
+     * coordinate copy of the problem in memory.
+     * Duplicate entries keep the highest derivative.
+     */
+    class streaming_builder {
+    public:
+      struct entry {
+	index_t row;
+	index_t col;
+	der_t der;
+      };
+
+      /* ordered by position, equal positions with the highest derivative (i.e. the smallest cost) first */
+      static bool entry_less(const entry& a, const entry& b) {
+	return a.row < b.row || (a.row == b.row && (a.col < b.col || (a.col == b.col && a.der < b.der)));
+      }
+
+      static bool same_position(const entry& a, const entry& b) {
+	return a.row == b.row && a.col == b.col;
+      }
+
+    private:
+      size_t dimension;
+      size_t chunk_size;
+      std::vector<entry> chunk;
+      /* sorted runs that did not fit into memory */
+      std::vector<std::FILE*> runs;
+
+      void sort_chunk();
+      void spill();
+
+      /* feed all entries in row-major order without duplicates to push_back */
+      template<class Sink> void merge(Sink&& push_back);
+
+    public:
+      /* one million entries are 12-16 MB */
+      static const size_t default_chunk_size = 1 << 20;
+
+      streaming_builder(size_t dim, size_t chunk_entries = default_chunk_size);
+
+      ~streaming_builder();
+
+      streaming_builder(const streaming_builder&) = delete;
+      streaming_builder& operator=(const streaming_builder&) = delete;
+
+      /**
+       * add the (maximal) derivative of variable in equation 
+       * throws std::runtime_error if either is out of range or the derivative does not fit der_t
+       */
+      void append(size_t equation, size_t variable, int derivative) {
+	if (equation >= dimension || variable >= dimension)
+	  throw std::runtime_error("streaming_builder: entry outside of the dimension");
+	const long long cost = -static_cast<long long>(derivative);
+	if (cost < std::numeric_limits<der_t>::min() || cost > std::numeric_limits<der_t>::max())
+	  throw std::runtime_error("streaming_builder: derivative does not fit der_t");
+
+	chunk.push_back(entry { index_t(equation), index_t(variable), der_t(cost) });
+	if (chunk.size() >= chunk_size)
+	  spill();
+      }
+
+      /**
+       * Build the problem from all appended entries, 
+       * afterwards this builder is empty.
+       */
+      InputProblem build();
+
+      /**
+       * Write all appended entries as a mapped_sigma_matrix file, 
+       * i.e. without ever holding the whole problem in memory.
+       * Afterwards this builder is empty.
+       */
+      void write_mapped(const std::string& path);
+
+      /* number of runs written to temporary files so far */
+      size_t spilled_runs() const { return runs.size(); }
+    };
+  }
+}
+
+#endif
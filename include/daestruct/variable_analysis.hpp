@@ -41,6 +41,15 @@ namespace daestruct {
       std::set<int> deletedRows;
       std::set<int> deletedCols;      
       std::vector<NewRow> newRows;
+
+      /**
+       * Add all changes of other (w.r.t. the same problem) to this change, 
+       * so that both are applied with a single ChangedProblem.
+       * The new rows and variables of other are numbered after the ones of 
+       * this change, i.e. shifted by newRows.size() and newVars (before merging).
+       * Neither change may refer to rows or variables the other one deletes.
+       */
+      void merge(const StructChange& other);
     };
 
     struct ChangedProblem {
@@ -51,10 +60,17 @@ namespace daestruct {
       size_t old_rows;
       size_t dimension;
       sigma_matrix sigma;
-      std::vector<size_t> row_assignment;
-      std::vector<size_t> col_assignment;
+      AnalysisOptions options;
+      std::vector<index_t> row_assignment;
+      std::vector<index_t> col_assignment;
       std::vector<int> dual_columns;
       std::vector<int> dual_rows;
+      /* cost of the (partial) row_assignment */
+      int assignment_cost = 0;
+      /* whether the vectors above can still be used to warm-start the LAP */
+      bool warm_start = false;
+      /* the rows without an assignment (deleted assignments and new rows), in increasing order */
+      std::vector<index_t> free_rows;
       std::vector<bool> row_changed;
       boost::icl::interval_map<int, int> colOffsets;
       boost::icl::interval_map<int, int> rowOffsets;
@@ -65,7 +81,21 @@ namespace daestruct {
       ChangedProblem(const ChangedProblem& prob, const AnalysisResult& result,
 		     const StructChange& delta);
 
+      /**
+       * Warm-starts the LAP from copies of the assignment and duals of the original problem
+       */
       AnalysisResult pryceAlgorithm() const;
+
+      /**
+       * pryceAlgorithm() answered from (and stored in) the given cache
+       */
+      AnalysisResult pryceAlgorithm(AnalysisCache& cache) const;
+
+      /**
+       * pryceAlgorithm(), moving the assignment and duals of the original problem into
+       * the LAP instead of copying them. Any further analysis starts from scratch.
+       */
+      AnalysisResult pryceAlgorithmConsuming();
     };
 
     
@@ -46,6 +46,24 @@ extern "C" {
 
   void daestruct_diff_set_new(struct daestruct_diff* diff, int newEquation, int unknown, int der);
 
+  /**
+   * number of equations added by @diff
+   */
+  int daestruct_diff_equations(struct daestruct_diff* diff);
+
+  /**
+   * number of unknowns added by @diff
+   */
+  int daestruct_diff_unknowns(struct daestruct_diff* diff);
+
+  /**
+   * add all changes of @other to @target, both must refer to the same problem
+   * the new equations and unknowns of @other are numbered after the ones of @target,
+   * i.e. shifted by daestruct_diff_equations(target) and daestruct_diff_unknowns(target) 
+   * before merging. @other is not modified.
+   */
+  void daestruct_diff_merge(struct daestruct_diff* target, struct daestruct_diff* other);
+
   /**
    * A problem that has been derived from an older problem
    */
@@ -69,8 +87,74 @@ extern "C" {
 
   void daestruct_changed_delete(struct daestruct_changed* changed);
 
+  /**
+   * write the incidence matrix of the changed problem as a Matrix Market file
+   * (see daestruct_input_write), returns 0 on success
+   */
+  int daestruct_changed_write(struct daestruct_changed* changed, const char* path);
+
+  /**
+   * build the index-reduced system of the changed problem (see daestruct_reduce)
+   */
+  struct daestruct_reduced* daestruct_changed_reduce(struct daestruct_changed* changed, struct daestruct_result* result);
+
+  /**
+   * run the structural analysis on the changed problem
+   * the returned pointer must be deleted with daestruct_result_delete()
+   * returns NULL if the analysis fails (see daestruct_analyse())
+   */
   struct daestruct_result* daestruct_changed_analyse(struct daestruct_changed* problem);
 
+  /**
+   * like daestruct_changed_analyse(), but returns a copy of the cached result if
+   * a problem with the same structure has been analysed using @cache before
+   * (see daestruct_cache_new())
+   */
+  struct daestruct_result* daestruct_changed_analyse_cached(struct daestruct_changed* problem, struct daestruct_cache* cache);
+
+  /**
+   * Speculative analysis of likely changes on background threads
+   */
+  struct daestruct_speculation;
+
+  /**
+   * start speculating about changes of @original
+   * @original and @result are copied (the rows of the matrix are shared until modified)
+   * the returned pointer must be deleted with daestruct_speculation_delete()
+   */
+  struct daestruct_speculation* daestruct_speculate_orig(struct daestruct_input* original, 
+							 struct daestruct_result* result);
+
+  /**
+   * start speculating about changes of @original
+   * @original and @result are copied (the rows of the matrix are shared until modified)
+   * the returned pointer must be deleted with daestruct_speculation_delete()
+   */
+  struct daestruct_speculation* daestruct_speculate(struct daestruct_changed* original, 
+						    struct daestruct_result* result);
+
+  /**
+   * start analysing @diff in the background (@diff is copied)
+   * returns the candidate id for daestruct_speculation_commit()
+   */
+  int daestruct_speculation_add(struct daestruct_speculation* spec, struct daestruct_diff* diff);
+
+  /**
+   * get the changed problem of the given candidate (waits until it has been analysed)
+   * its analysis result is stored in @result, both must be deleted by the caller
+   * every candidate can be committed only once
+   * returns NULL (and sets *@result to NULL) if the candidate is unknown, 
+   * was already committed or its analysis failed
+   */
+  struct daestruct_changed* daestruct_speculation_commit(struct daestruct_speculation* spec, int candidate, 
+							 struct daestruct_result** result);
+
+  /**
+   * delete the speculation and all candidates that were not committed
+   * candidates still being analysed are cancelled, this waits until they have stopped
+   */
+  void daestruct_speculation_delete(struct daestruct_speculation* spec);
+
 #ifdef __cplusplus
 }
 #endif
@@ -20,30 +20,121 @@
 #ifndef DAESTRUCT_LAP_HPP
 #define DAESTRUCT_LAP_HPP
 
+#include <atomic>
 #include <iostream>
 #include <vector>
 #include <climits>
 
 #include <daestruct/sigma_matrix.hpp>
 
+namespace daestruct {
+  class mapped_sigma_matrix;
+}
+
 struct solution {
   int cost;
-  std::vector<size_t> rowsol;
-  std::vector<size_t> colsol;
+  /* number of rows without an assignment, > 0 iff the cost matrix is structurally singular */
+  size_t unassigned;
+  std::vector<daestruct::index_t> rowsol;
+  std::vector<daestruct::index_t> colsol;
   std::vector<int> u;
   std::vector<int> v;  
+  /* number of shortest augmenting path searches (single rows and phases) and of the columns they scanned */
+  size_t augmentations = 0;
+  size_t scanned_columns = 0;
+  /* searches of AUGMENT_PARALLEL repeated after a conflict, they are part of augmentations */
+  size_t repeated_searches = 0;
+  /* rows assigned by the initialization, by the augmenting row reduction and by the augmentation of lap() */
+  size_t initialized_rows = 0;
+  size_t row_reduced_rows = 0;
+  size_t augmented_rows = 0;
+};
+
+/* how lap() augments the rows that are still free after its initialization */
+enum augmentation_mode {
+  AUGMENT_ADAPTIVE, /* single rows while their searches are cheap, then phases */
+  AUGMENT_ROWS,     /* one shortest augmenting path search per free row */
+  AUGMENT_PHASES,   /* one Dijkstra forest from all free rows per phase, with several disjoint augmentations */
+  AUGMENT_PARALLEL  /* searches for several free rows at once on threads, conflicting ones are repeated */
+};
+
+/* how lap() assigns the first rows, before the augmenting row reduction */
+enum lap_initialization {
+  INIT_COLUMN_REDUCTION, /* every column to its cheapest row, if that row is still free */
+  INIT_KARP_SIPSER       /* a greedy maximal matching of the entries that are the cheapest of their row */
+};
+
+struct lap_options {
+  augmentation_mode augmentation = AUGMENT_ADAPTIVE;
+
+  /* threads of AUGMENT_PARALLEL (0: as many as there are cores) */
+  unsigned threads = 0;
+
+  lap_initialization initialization = INIT_COLUMN_REDUCTION;
+
+  /* solve matrices of dimension <= 32 as dense ones (structurally singular ones excepted) */
+  bool dense_small_matrices = true;
+
+  /* once *cancel is set the LAP stops between augmentations, leaving the remaining rows unassigned */
+  const std::atomic<bool>* cancel = nullptr;
+
+  bool cancelled() const { return cancel && *cancel; }
 };
 
 /**
  * Solve the integer linear assignment problem defined by the cost matrix
+ * Absent entries are not priced, they are simply no edges. If no complete 
+ * assignment exists, the returned solution is a maximal one and has unassigned > 0.
  */
-solution lap(const daestruct::sigma_matrix& cost);
+solution lap(const daestruct::sigma_matrix& cost, const lap_options& options = lap_options());
+
+/**
+ * Solve the integer linear assignment problem defined by a memory-mapped cost matrix
+ */
+solution lap(const daestruct::mapped_sigma_matrix& cost, const lap_options& options = lap_options());
+
+/**
+ * Solve the integer linear assignment problem by cost scaling (Goldberg and Kennedy)
+ * The result is the same kind of solution as the one of lap() (an optimal assignment, 
+ * which may differ from the one of lap() if there are several, and tight duals).
+ * It takes log(dimension * max |cost|) passes over all rows, so it is slower than lap()
+ * on easy structures, but it does not depend on augmenting paths staying short.
+ * augmentations and scanned_columns count the bids and the entries they scanned.
+ * A structurally singular matrix is left to lap(). Of the options only cancel is used,
+ * a cancelled solution leaves all rows unassigned.
+ */
+solution lap_cost_scaling(const daestruct::sigma_matrix& cost, const lap_options& options = lap_options());
+
+solution lap_cost_scaling(const daestruct::mapped_sigma_matrix& cost, const lap_options& options = lap_options());
 
 /**
  * Solve the integer linear assignment problem using an older (partiall) assignment
+ * The prices of unassigned columns are recalculated from the assigned rows.
  */
 solution delta_lap(const daestruct::sigma_matrix& assigncost, const std::vector<int>& _u, const std::vector<int>& _v, 
-		   const std::vector<size_t>& _rowsol, const std::vector<size_t>& _colsol);
+		   const std::vector<daestruct::index_t>& _rowsol, const std::vector<daestruct::index_t>& _colsol);
+
+/**
+ * Solve the integer linear assignment problem using an older (partial) assignment, 
+ * reusing the given vectors.
+ * Only the free rows are augmented, finding them takes a scan over rowsol (see below).
+ * This requires a feasible dual for the given assignment: u[i] + v[j] <= cost(i,j) for every 
+ * entry of an assigned row i (with equality on the assignment) and cost the sum of the 
+ * assigned entries. The u of free rows and the v of columns that only have entries in free
+ * rows are ignored. Of the options only cancel is used.
+ */
+solution delta_lap(const daestruct::sigma_matrix& assigncost, std::vector<int>&& u, std::vector<int>&& v, 
+		   std::vector<daestruct::index_t>&& rowsol, std::vector<daestruct::index_t>&& colsol, int cost,
+		   const lap_options& options = lap_options());
+
+/**
+ * delta_lap() for the given free rows of rowsol (all of them, in the order they are augmented).
+ * The work depends on the change only, not on the dimension: the search state is kept 
+ * per thread between calls and only grows with the largest dimension seen.
+ */
+solution delta_lap(const daestruct::sigma_matrix& assigncost, std::vector<int>&& u, std::vector<int>&& v, 
+		   std::vector<daestruct::index_t>&& rowsol, std::vector<daestruct::index_t>&& colsol, int cost,
+		   const std::vector<daestruct::index_t>& free, const lap_options& options = lap_options());
 
 std::ostream& operator<<(std::ostream& o, const solution& s);
 
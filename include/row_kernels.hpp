@@ -0,0 +1,94 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DAESTRUCT_ROW_KERNELS_HPP
+#define DAESTRUCT_ROW_KERNELS_HPP
+
+#include <cstddef>
+
+#include <daestruct/sigma_matrix.hpp>
+#include <daestruct/mapped_sigma_matrix.hpp>
+
+/**
+ * Scans over a single row of the cost matrix, used by the LAP.
+ * Rows of sigma_matrix (a map_array of std::pair<index_t, der_t>) and of 
+ * mapped_sigma_matrix are both contiguous arrays of {column, cost}, so the 
+ * reduced costs cost - v[column] of a row can be computed with gathers.
+ * Entries are read through their own type (column_of, cost_of), only the 
+ * gathers look at the bytes of a row.
+ * The implementation (scalar, AVX2 or AVX-512) is chosen at runtime: AVX2 if 
+ * the CPU supports it, DAESTRUCT_SIMD=scalar|avx2|avx512 overrides the choice.
+ */
+namespace daestruct {
+  namespace kernels {
+
+    typedef sigma_matrix::row_t::array_type::value_type sigma_entry;
+    typedef mapped_sigma_matrix::entry mapped_entry;
+
+    inline index_t column_of(const sigma_entry& e) { return e.first; }
+    inline der_t cost_of(const sigma_entry& e) { return e.second; }
+    inline index_t column_of(const mapped_entry& e) { return e.column; }
+    inline der_t cost_of(const mapped_entry& e) { return e.cost; }
+
+    enum isa {
+      ISA_SCALAR,
+      ISA_AVX2,
+      ISA_AVX512
+    };
+
+    /* the implementation in use */
+    isa active_isa();
+
+    /**
+     * use the given implementation, returns false (and changes nothing) if the CPU does not support it
+     * not to be called while an analysis is running
+     */
+    bool select_isa(isa which);
+
+    /**
+     * out[k] = cost_of(row[k]) - v[column_of(row[k])] for k < n
+     */
+    void reduced_costs(const sigma_entry* row, size_t n, const int* v, int* out);
+    void reduced_costs(const mapped_entry* row, size_t n, const int* v, int* out);
+
+    /* positions of the smallest and second smallest value */
+    struct two_smallest_t {
+      size_t first;
+      size_t second;
+      bool has_second;
+    };
+
+    /**
+     * The first position of the minimum of h[0 .. n) and the first position of 
+     * the minimum of the remaining values, n > 0. 
+     * This is the order in which the row reduction of the LAP visits them.
+     */
+    two_smallest_t two_smallest(const int* h, size_t n);
+
+    inline const sigma_entry* entries(const sigma_matrix::row_t& row) {
+      return row.data().begin();
+    }
+
+    inline const mapped_entry* entries(const mapped_sigma_matrix::row_t& row) {
+      return row.data();
+    }
+  }
+}
+
+#endif
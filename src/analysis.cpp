@@ -18,29 +18,65 @@
  */
 
 #include <daestruct/analysis.hpp>
+#include <daestruct/analysis_cache.hpp>
+#include <daestruct/mapped_sigma_matrix.hpp>
 #include <boost/timer/timer.hpp>
 
+#include <algorithm>
+#include <climits>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
 #include <vector>
 
 #include "lap.hpp"
+#include "barrier.hpp"
 #include "prettyprint.hpp"
 #include <iostream>
 
 namespace daestruct {
   namespace analysis {
   
-    void solveByFixedPoint(const std::vector<size_t>& assignment,  
-			   const sigma_matrix& sigma,
-			   std::vector<int>& c, std::vector<int>& d) {
+    /*
+     * The offsets grow along paths of the assignment graph, for an optimal assignment
+     * the longest path has less than dimension edges, i.e. the iteration ends 
+     * after at most dimension + 1 sweeps
+     */
+    static void not_converging() {
+      throw std::invalid_argument("the offsets do not converge, the assignment is not optimal");
+    }
+
+    /* every equation needs to be assigned to a variable it depends on */
+    template<class Matrix>
+    static void check_assignment(const std::vector<index_t>& assignment, const Matrix& sigma) {
+      if (assignment.size() != sigma.dimension())
+	throw std::invalid_argument("the assignment does not match the dimension of sigma");
+      for (size_t i = 0; i < assignment.size(); i++)
+	if (assignment[i] >= sigma.dimension() || !sigma.find_element(i, assignment[i]))
+	  throw std::invalid_argument("equation " + std::to_string(i) + " is assigned to a variable it does not depend on");
+    }
+
+    template<class Matrix>
+    static void solveByFixedPointImpl(const std::vector<index_t>& assignment,  
+				      const Matrix& sigma,
+				      std::vector<int>& c, std::vector<int>& d,
+				      const std::atomic<bool>* cancel) {
       bool converged = false;
+      size_t sweeps = 0;
 
       while (!converged) {
+	if (cancel && *cancel)
+	  return;
+	if (sweeps++ > sigma.dimension() + 1)
+	  not_converging();
 	converged = true;
 	
-	for (auto row_iter = sigma.rows().cbegin(); row_iter != sigma.rows().cend(); row_iter++) {	      
-	  const size_t i = row_iter - sigma.rows().cbegin();
+	for (size_t i = 0; i < sigma.dimension(); i++) {
+	  const auto& row = sigma.row(i);
 
-	  for (auto col_iter = (*row_iter).begin(); col_iter != (*row_iter).end(); col_iter++) {
+	  for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++) {
 	    const size_t j = col_iter.index();
 	    const int a = -1 * *col_iter + c[i];
 	    if (a > d[j]) {
@@ -70,19 +106,307 @@ namespace daestruct {
       }
     }
 
-    AnalysisResult InputProblem::pryceAlgorithm() const {
+    /* below this many equations per thread the serial iteration is faster */
+    static const size_t min_rows_per_thread = 1 << 15;
+
+    /**
+     * The fixed-point iteration with the d pass split over columns (of a column index 
+     * built once) and the c pass split over rows. The new d[j] is the maximum of d[j] and
+     * c[i] - sigma(i,j) over the column, which does not depend on the order of the rows,
+     * so c and d are exactly those of solveByFixedPointImpl().
+     */
+    template<class Matrix>
+    static void solveByFixedPointParallel(const std::vector<index_t>& assignment,  
+					  const Matrix& sigma,
+					  std::vector<int>& c, std::vector<int>& d, unsigned threads,
+					  const std::atomic<bool>* cancel) {
+      const size_t n = sigma.dimension();
+
+      std::vector<size_t> col_start(n + 1);
+      for (size_t i = 0; i < n; i++) {
+	const auto& row = sigma.row(i);
+	for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++)
+	  col_start[col_iter.index() + 1]++;
+      }
+      std::partial_sum(col_start.begin(), col_start.end(), col_start.begin());
+
+      struct column_entry {
+	index_t row;
+	int cost;
+      };
+      std::vector<column_entry> columns(col_start[n]);
+      std::vector<size_t> next(col_start.begin(), col_start.end() - 1);
+      std::vector<int> assigned_cost(n);
+      for (size_t i = 0; i < n; i++) {
+	const auto& row = sigma.row(i);
+	for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++)
+	  columns[next[col_iter.index()]++] = column_entry { index_t(i), *col_iter };
+	assigned_cost[i] = sigma(i, assignment[i]);
+      }
+
+      /* columns are split by their number of entries, rows evenly */
+      std::vector<size_t> first_column(threads + 1, n), first_row(threads + 1, n);
+      for (unsigned k = 0; k < threads; k++) {
+	first_column[k] = std::lower_bound(col_start.begin(), col_start.end(), 
+					   columns.size() / threads * k) - col_start.begin();
+	first_row[k] = n / threads * k;
+      }
+
+      std::vector<char> changed(threads);
+      bool converged = false;
+      /* read from cancel by the first worker, so that all of them stop after the same sweep */
+      bool stop = false;
+      /* the workers meet twice per sweep */
+      barrier sweep(threads);
+      auto iterate = [&](unsigned k) {
+	for (size_t sweeps = 0; sweeps <= n + 1; sweeps++) {
+	  for (size_t j = first_column[k]; j < first_column[k + 1]; j++) {
+	    int dj = d[j];
+	    for (size_t e = col_start[j]; e < col_start[j + 1]; e++)
+	      dj = std::max(dj, c[columns[e].row] - columns[e].cost);
+	    d[j] = dj;
+	  }
+	  sweep.wait();
+
+	  bool c_changed = false;
+	  for (size_t i = first_row[k]; i < first_row[k + 1]; i++) {
+	    const int c2 = d[assignment[i]] + assigned_cost[i];
+	    c_changed |= c[i] != c2;
+	    c[i] = c2;
+	  }
+	  changed[k] = c_changed;
+	  if (k == 0)
+	    stop = cancel && *cancel;
+	  sweep.wait();
+
+	  /* every worker sees the same flags, nobody writes them before the next barrier */
+	  if (stop)
+	    return;
+	  if (std::find(changed.begin(), changed.end(), true) == changed.end()) {
+	    if (k == 0)
+	      converged = true;
+	    return;
+	  }
+	}
+      };
+
+      std::vector<std::thread> workers;
+      for (unsigned k = 1; k < threads; k++)
+	workers.emplace_back(iterate, k);
+      iterate(0);
+      for (std::thread& w : workers)
+	w.join();
+
+      if (!converged && !stop)
+	not_converging();
+    }
+
+    template<class Matrix>
+    static void solveByFixedPointThreaded(const std::vector<index_t>& assignment,  
+					  const Matrix& sigma,
+					  std::vector<int>& c, std::vector<int>& d, unsigned threads,
+					  const std::atomic<bool>* cancel) {
+      check_assignment(assignment, sigma);
+
+      if (threads == 0) {
+	threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::max<size_t>(1, std::min<size_t>(threads, sigma.dimension() / min_rows_per_thread));
+      }
+
+      if (threads > 1)
+	solveByFixedPointParallel(assignment, sigma, c, d, threads, cancel);
+      else
+	solveByFixedPointImpl(assignment, sigma, c, d, cancel);
+    }
+
+    void solveByFixedPoint(const std::vector<index_t>& assignment,  
+			   const sigma_matrix& sigma,
+			   std::vector<int>& c, std::vector<int>& d, unsigned threads,
+			   const std::atomic<bool>* cancel) {
+      solveByFixedPointThreaded(assignment, sigma, c, d, threads, cancel);
+    }
+
+    void solveByFixedPoint(const std::vector<index_t>& assignment,  
+			   const mapped_sigma_matrix& sigma,
+			   std::vector<int>& c, std::vector<int>& d, unsigned threads,
+			   const std::atomic<bool>* cancel) {
+      /* every iteration (or building the column index) scans all rows in order */
+      sigma.advise(mapped_sigma_matrix::ACCESS_SEQUENTIAL);
+      solveByFixedPointThreaded(assignment, sigma, c, d, threads, cancel);
+      sigma.advise(mapped_sigma_matrix::ACCESS_NORMAL);
+    }
+
+    /**
+     * With the assignment fixed, d[j] = c[i] - cost(i,j) for the equation i assigned to j,
+     * and the smallest c is the longest path to every equation in the graph with an edge 
+     * k -> i of weight cost(i,j) - cost(k,j) for every entry (k, j) of the variable j of i,
+     * starting from the lower bound max(0, cost(i,j)) (i.e. c >= 0 and d >= 0).
+     * As shortest paths (negated weights) with the potential -u, the length of every edge 
+     * is the reduced cost cost(k,j) - u[k] - v[j] >= 0 of the entry, so Dijkstra from a 
+     * source connected to every equation relaxes every entry once.
+     */
+    template<class Matrix>
+    static void solveByPotentialsImpl(const std::vector<index_t>& assignment,  
+				      const Matrix& sigma,
+				      const std::vector<int>& u, const std::vector<int>& v,
+				      std::vector<int>& c, std::vector<int>& d) {
+      const size_t n = sigma.dimension();
+      if (assignment.size() != n || u.size() != n || v.size() != n)
+	throw std::invalid_argument("the assignment or the duals do not match the dimension of sigma");
+
+      std::vector<index_t> assigned_row(n, n);
+      std::vector<int> assigned_cost(n);
+      long long source = LLONG_MIN;
+      for (size_t i = 0; i < n; i++) {
+	const index_t j = assignment[i];
+	const der_t* entry = j < n ? sigma.find_element(i, j) : nullptr;
+	if (!entry)
+	  throw std::invalid_argument("equation " + std::to_string(i) + " is assigned to a variable it does not depend on");
+	if (assigned_row[j] != n)
+	  throw std::invalid_argument("variable " + std::to_string(j) + " is assigned twice");
+	assigned_row[j] = i;
+
+	assigned_cost[i] = *entry;
+	if (u[i] + v[j] != assigned_cost[i])
+	  throw std::invalid_argument("the duals are not tight on the assignment");
+	source = std::max(source, (long long) std::max(0, assigned_cost[i]) - u[i]);
+      }
+
+      /* 
+       * reduced distances from the source, every equation is connected to it
+       * Most equations keep the length of that edge, so they are settled in the order 
+       * of it (a counting sort for the usual small range) and only the improved 
+       * ones go through a heap.
+       */
+      std::vector<long long> dist(n);
+      long long shortest = LLONG_MAX, longest = LLONG_MIN;
+      for (size_t i = 0; i < n; i++) {
+	dist[i] = source + u[i] - std::max(0, assigned_cost[i]);
+	shortest = std::min(shortest, dist[i]);
+	longest = std::max(longest, dist[i]);
+      }
+      const std::vector<long long> initial(dist);
+
+      std::vector<index_t> order(n);
+      if (n > 0 && (unsigned long long) (longest - shortest) <= 2 * n) {
+	std::vector<size_t> start(longest - shortest + 2);
+	for (size_t i = 0; i < n; i++)
+	  start[dist[i] - shortest + 1]++;
+	std::partial_sum(start.begin(), start.end(), start.begin());
+	for (size_t i = 0; i < n; i++)
+	  order[start[dist[i] - shortest]++] = i;
+      } else {
+	std::iota(order.begin(), order.end(), 0);
+	std::sort(order.begin(), order.end(), [&](index_t a, index_t b) { return dist[a] < dist[b]; });
+      }
+
+      typedef std::pair<long long, index_t> queued;
+      std::priority_queue<queued, std::vector<queued>, std::greater<queued>> improved;
+      std::vector<char> settled(n);
+      size_t next = 0;
+      for (;;) {
+	while (next < n && (settled[order[next]] || dist[order[next]] != initial[order[next]]))
+	  next++;
+	while (!improved.empty() && (settled[improved.top().second] || improved.top().first != dist[improved.top().second]))
+	  improved.pop();
+
+	index_t i;
+	if (next < n && (improved.empty() || dist[order[next]] <= improved.top().first))
+	  i = order[next++];
+	else if (!improved.empty()) {
+	  i = improved.top().second;
+	  improved.pop();
+	} else
+	  break;
+	settled[i] = true;
+
+	const auto& row = sigma.row(i);
+	for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++) {
+	  const size_t j = col_iter.index();
+	  const long long reduced = (long long) *col_iter - u[i] - v[j];
+	  if (reduced < 0)
+	    throw std::invalid_argument("the duals are not feasible");
+
+	  const index_t k = assigned_row[j];
+	  if (!settled[k] && dist[i] + reduced < dist[k]) {
+	    dist[k] = dist[i] + reduced;
+	    improved.push(queued(dist[k], k));
+	  }
+	}
+      }
+
+      c.resize(n);
+      d.resize(n);
+      for (size_t i = 0; i < n; i++)
+	c[i] = source + u[i] - dist[i];
+      for (size_t j = 0; j < n; j++)
+	d[j] = c[assigned_row[j]] - assigned_cost[assigned_row[j]];
+    }
+
+    void solveByPotentials(const std::vector<index_t>& assignment,  
+			   const sigma_matrix& sigma,
+			   const std::vector<int>& u, const std::vector<int>& v,
+			   std::vector<int>& c, std::vector<int>& d) {
+      solveByPotentialsImpl(assignment, sigma, u, v, c, d);
+    }
+
+    void solveByPotentials(const std::vector<index_t>& assignment,  
+			   const mapped_sigma_matrix& sigma,
+			   const std::vector<int>& u, const std::vector<int>& v,
+			   std::vector<int>& c, std::vector<int>& d) {
+      solveByPotentialsImpl(assignment, sigma, u, v, c, d);
+    }
+
+    AnalysisResult InputProblem::pryceAlgorithm(AnalysisCache& cache) const {
+      const AnalysisResult* cached = cache.lookup(sigma, options);
+      if (cached)
+	return *cached;
+
+      AnalysisResult result = pryceAlgorithm();
+      cache.store(sigma, options, result);
+      return result;
+    }
+
+    template<class Matrix>
+    static solution assign(const Matrix& sigma, const AnalysisOptions& options) {
+      lap_options lap_opts;
+      lap_opts.cancel = options.cancel;
+      return options.engine == ENGINE_COST_SCALING ? lap_cost_scaling(sigma, lap_opts) : lap(sigma, lap_opts);
+    }
+
+    /**
+     * Pryce's algorithm on any matrix that lap() and solveByFixedPoint() accept
+     */
+    template<class Matrix>
+    static AnalysisResult pryce(const Matrix& sigma, size_t dimension, const AnalysisOptions& options) {
       //std::cout << sigma << std::endl;
 
       /* solve linear assignment problem */
-      solution assignment = lap(sigma);
+      solution assignment = assign(sigma, options);
 
       std::cout << "lap solved: " << assignment.cost << std::endl;
       AnalysisResult result;
       result.row_assignment = std::move(assignment.rowsol);
       result.col_assignment = std::move(assignment.colsol);
+      result.augmentations = assignment.augmentations;
+      result.scanned_columns = assignment.scanned_columns;
+      if (options.keep_duals) {
+	result.u = std::move(assignment.u);
+	result.v = std::move(assignment.v);
+      }
       result.c.resize(dimension);
       result.d.resize(dimension);
 
+      if (options.cancelled()) {
+	result.status = ANALYSIS_CANCELLED;
+	return result;
+      }
+
+      if (assignment.unassigned > 0) {
+	result.status = ANALYSIS_STRUCTURALLY_SINGULAR;
+	return result;
+      }
+
       /*
       std::cout << assignment.v << std::endl;
       std::cout << assignment.u << std::endl;
@@ -98,23 +422,39 @@ namespace daestruct {
 
       /* run fix-point algorithm */
       std::cout << "Calculating smallest dual" << std::endl;
-      solveByFixedPoint(result.row_assignment, sigma, result.c, result.d);
+      if (options.offsets == OFFSETS_POTENTIALS) {
+	const std::vector<int>& u = options.keep_duals ? result.u : assignment.u;
+	const std::vector<int>& v = options.keep_duals ? result.v : assignment.v;
+	solveByPotentials(result.row_assignment, sigma, u, v, result.c, result.d);
+      } else
+	solveByFixedPoint(result.row_assignment, sigma, result.c, result.d, options.threads, options.cancel);
       //std::cout << "Canonical: c=" << result.c << " d=" << result.d << std::endl;
 
+      if (options.cancelled())
+	result.status = ANALYSIS_CANCELLED;
+
       return result;
     }
 
+    AnalysisResult InputProblem::pryceAlgorithm() const {
+      return pryce(sigma, dimension, options);
+    }
+
+    AnalysisResult MappedProblem::pryceAlgorithm() const {
+      return pryce(sigma, sigma.dimension(), options);
+    }
+
     sigma_matrix copy_defrag_noninflated(const sigma_matrix& compressed, const solution& comp_assignment,
 					 AnalysisResult& result, const compression& c) {
       sigma_matrix inflated ( result.row_assignment.size() );
       size_t si = 0;
       
-      for (auto row_iter = compressed.rows().cbegin(); row_iter != compressed.rows().cend(); row_iter++) {
-	const size_t i = row_iter - compressed.rows().cbegin();
+      for (size_t i = 0; i < compressed.dimension(); i++) {
+	const sigma_matrix::row_t& row = compressed.row(i);
 
 	if (si >= c.instances.size() || i != c.instances[si].s) {
 	  /* copy row */
-	  for (auto col_iter = (*row_iter).begin(); col_iter != (*row_iter).end(); col_iter++)
+	  for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++)
 	    inflated.insert(i - si, col_iter.index(), *col_iter);
 	  
 	  /* copy assignment */
@@ -139,11 +479,19 @@ namespace daestruct {
       for (const compressible_instance& inst : c.instances) {
 	/* which public variable does this component solve ? */
 	const int k = comp_assignment.rowsol[inst.s] - inst.q;
-	auto row_begin = inst.c->sigma.rows().cbegin();
 
-	for (auto row_iter = inst.c->sigma.rows().cbegin(); ((size_t)(row_iter - row_begin)) < inst.c->p + 1; row_iter++)
-	  for (auto col_iter = (*row_iter).begin(); col_iter != (*row_iter).end(); col_iter++) {
-	    const size_t i = (row_iter - row_begin) + row_offset;
+	/* get the required matching */
+	const index_t* M = inst.c->assignment(k);
+	for (size_t ci = 0; ci < inst.c->p + 1; ci++) {
+	  const size_t i = ci + row_offset;
+
+	  /* inflate matching as well */
+	  const size_t i_m = M[ci];
+	  const size_t j_m = (i_m >= inst.c->q) ? i_m + col_offset - inst.c->q : i_m + inst.q;
+	  result.row_assignment.at(i) = j_m;
+	  result.col_assignment.at(j_m) = i;
+
+	  for (auto col_iter = inst.c->sigma.row(ci).begin(); col_iter != inst.c->sigma.row(ci).end(); col_iter++) {
 	    const size_t j = 	    
 	      (col_iter.index() >= inst.c->q) ?  // private variable
 	      col_iter.index() + col_offset - inst.c->q
@@ -151,20 +499,8 @@ namespace daestruct {
 	      col_iter.index() + inst.q; //public var
 	    ;	    
 	    inflated.insert(i, j, *col_iter);
-
-	    /* get the required matching */
-	    const std::vector<size_t>& M = inst.c->M[k];
-
-	    /* inflate matching as well */
-	    const size_t i_m = M.at(row_iter - row_begin);
-	    if (i_m >= inst.c->q) {
-	      result.row_assignment.at(i) = i_m + col_offset - inst.c->q;
-	      result.col_assignment.at(i_m + col_offset - inst.c->q) = i;
-	    } else {
-	      result.row_assignment.at(i) = i_m + inst.q;
-	      result.col_assignment.at(i_m + inst.q) = i;
-	    }
 	  }
+	}
 
 	/* book keeping */
 	result.inflated.component_cols.push_back(col_offset);
@@ -181,6 +517,13 @@ namespace daestruct {
       AnalysisResult result;
       result.row_assignment.resize(dimension + c.variables());
       result.col_assignment.resize(dimension + c.variables());
+
+      if (comp_assignment.unassigned > 0) {
+	result.status = ANALYSIS_STRUCTURALLY_SINGULAR;
+	result.c.resize(dimension + c.variables());
+	result.d.resize(dimension + c.variables());
+	return result;
+      }
       
       sigma_matrix inflated = copy_defrag_noninflated(sigma, comp_assignment, result, c);
 
@@ -196,7 +539,7 @@ namespace daestruct {
       int sizep = (100 * dimension) / inflated.dimension() ;
       std::cout << "Compressed (" << sizep << "%) LAP solved and inflated. Value is: " << cost << std::endl;
       
-      solveByFixedPoint(result.row_assignment, inflated, result.c, result.d);
+      solveByFixedPoint(result.row_assignment, inflated, result.c, result.d, options.threads);
       
       return result;
     }
@@ -209,44 +552,42 @@ namespace daestruct {
       return inflated.component_cols[k] + var;
     }
     
-    compressible::compressible(int pub_v, int pri_v, const sigma_matrix& s) : p(pri_v), q(pub_v), sigma(p+q) {
-      // copy only the interesting parts, keeps memory requirements lower and (theoretically) saves time
-      auto row_begin = s.rows().cbegin();
-      for (auto row_iter = row_begin; row_iter != s.rows().cend() && ((size_t)(row_iter - row_begin)) < p+1; row_iter++)
-	for (auto col_iter = (*row_iter).begin(); col_iter != (*row_iter).end(); col_iter++)
-	  sigma.insert(row_iter - row_begin, col_iter.index(), *col_iter);	
-    }
+    compressible::compressible(int pub_v, int pri_v) : p(pri_v), q(pub_v), sigma(p+q) {}
 
     /**
      * Seal this sub-component (i.e. afterwards set_incidence is a no-op)
+     * M_q is the LAP of the p+1 equations over q and the private variables
      */
     compressible compressible_builder::build() {
-      compressible compr(q, p, sigma);
+      compressible compr(q, p);
+      compr.M.reserve(q * (p+1));
+
+      /* the equations in the numbering of the sealed component: q publics, then the privates */
+      for (size_t i = 0; i < p+1; i++) {
+	const sigma_matrix::row_t& row = sigma.row(i);
+	for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++)
+	  compr.sigma.insert(i, col_iter.index() - 1 + q, *col_iter);
+      }
+      for (size_t j = 0; j < q; j++) {
+	const sigma_matrix::row_t& incidence = publics.row(j);
+	for (auto col_iter = incidence.begin(); col_iter != incidence.end(); col_iter++)
+	  compr.sigma.insert(col_iter.index(), j, *col_iter);
+      }
 
       for (size_t j = 0; j < q; j++) {
-	/* prepare identity matrix for the remaining rows and public vars */
-	int s_row = p+1;
-	for (size_t pub_j = 0; pub_j < q; pub_j++) {
-	  if(pub_j != j) {
-	    sigma.insert(s_row++, pub_j, 0);	     
-	  }
-	}
+	/* border the equations with j */
+	const sigma_matrix::row_t& incidence = publics.row(j);
+	for (auto col_iter = incidence.begin(); col_iter != incidence.end(); col_iter++)
+	  sigma.insert(col_iter.index(), 0, *col_iter);
 
 	solution sol = lap(sigma);
-	std::vector<size_t> M_i;
-	M_i.resize(p+1);
 	for (size_t i = 0; i < p+1; i++)
-	  M_i[i] = sol.rowsol[i];
-	compr.M.push_back(M_i);
+	  compr.M.push_back(sol.rowsol[i] > p ? BIG : sol.rowsol[i] == 0 ? j : sol.rowsol[i] - 1 + q);
 	compr.cost.push_back(sol.cost);
+	compr.feasible.push_back(sol.unassigned == 0);
 
-	/* reset the identity matrix for the next run */
-	s_row = p+1;
-	for (size_t pub_j = 0; pub_j < q; pub_j++) {
-	  if(pub_j != j) {
-	    sigma.insert(s_row++, pub_j, BIG);	     
-	  }
-	}
+	for (auto col_iter = incidence.begin(); col_iter != incidence.end(); col_iter++)
+	  sigma.erase(col_iter.index(), 0);
       }	
 
       return compr;
@@ -254,17 +595,18 @@ namespace daestruct {
 
     void compressible_builder::set_private_incidence(int i, int j, int val) {
       //TODO: exception if j > p || i > p+1
-      sigma.insert(i, j + q, val);
+      sigma.insert(i, j + 1, val);
     }
 
     void compressible_builder::set_public_incidence(int i, int j, int val) {
       //TODO: exception if j > q || i > p+1
-      sigma.insert(i, j, val);
+      publics.insert(j, i, val);
     }
 
     void compressible_instance::insert_incidence(sigma_matrix& sigma) const {
       for (size_t j = 0; j < c->q; j++)
-	sigma.insert(s, j + q, c->cost[j]);
+	if (c->feasible[j])
+	  sigma.insert(s, j + q, c->cost[j]);
     }
 
 
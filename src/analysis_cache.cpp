@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <daestruct/analysis_cache.hpp>
+
+namespace daestruct {
+  namespace analysis {
+
+    const AnalysisResult* AnalysisCache::lookup(const sigma_matrix& sigma, const AnalysisOptions& options) {
+      auto it = index.find(key_of(sigma, options));
+      if (it == index.end()) {
+	misses++;
+	return nullptr;
+      }
+
+      hits++;
+      results.splice(results.begin(), results, it->second);
+      return &it->second->second;
+    }
+
+    void AnalysisCache::store(const sigma_matrix& sigma, const AnalysisOptions& options, const AnalysisResult& result) {
+      /* a cancelled analysis is no answer for anybody */
+      if (capacity == 0 || result.status == ANALYSIS_CANCELLED)
+	return;
+
+      /* a hit does not repeat the work of the analysis */
+      AnalysisResult stored = result;
+      stored.augmentations = 0;
+      stored.scanned_columns = 0;
+
+      const key k = key_of(sigma, options);
+      auto it = index.find(k);
+      if (it != index.end()) {
+	it->second->second = std::move(stored);
+	results.splice(results.begin(), results, it->second);
+	return;
+      }
+
+      if (results.size() >= capacity) {
+	index.erase(results.back().first);
+	results.pop_back();
+      }
+
+      results.emplace_front(k, std::move(stored));
+      index[k] = results.begin();
+    }
+  }
+}
@@ -0,0 +1,57 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DAESTRUCT_BARRIER_HPP
+#define DAESTRUCT_BARRIER_HPP
+
+#include <condition_variable>
+#include <mutex>
+
+namespace daestruct {
+
+  /**
+   * A reusable barrier for a fixed number of threads (std::barrier is C++20)
+   */
+  class barrier {
+  public:
+    explicit barrier(unsigned count) : count(count), waiting(0), generation(0) {}
+
+    void wait() {
+      std::unique_lock<std::mutex> lock(mutex);
+      const unsigned arrived_in = generation;
+      if (++waiting == count) {
+	waiting = 0;
+	generation++;
+	all_arrived.notify_all();
+      } else {
+	all_arrived.wait(lock, [&] { return generation != arrived_in; });
+      }
+    }
+
+  private:
+    const unsigned count;
+    unsigned waiting;
+    unsigned generation;
+    std::mutex mutex;
+    std::condition_variable all_arrived;
+  };
+
+}
+
+#endif
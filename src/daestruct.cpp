@@ -22,8 +22,12 @@
 #include <daestruct/analysis.hpp>
 #include <daestruct/sigma_matrix.hpp>
 #include <daestruct/c_cpp_interface.hpp>
+#include <daestruct/matrix_market.hpp>
 #include <boost/timer/timer.hpp>
 
+#include <algorithm>
+#include <fstream>
+
 extern "C" {
 
   using namespace daestruct::analysis;
@@ -44,6 +48,39 @@ extern "C" {
     return static_cast<daestruct_input*>(new InputProblem(*problem));
   }
 
+  struct daestruct_input_stream* daestruct_input_stream_create(int dimension, int chunk_entries) {
+    return new daestruct_input_stream(dimension, chunk_entries > 0 ? chunk_entries : streaming_builder::default_chunk_size);
+  }
+
+  /* range errors cannot cross the C boundary */
+  int daestruct_input_stream_append(struct daestruct_input_stream* stream, int variable, int equation, int derivative) {
+    try {
+      stream->append(equation, variable, derivative);
+      return 0;
+    } catch (const std::exception&) {
+      return -1;
+    }
+  }
+
+  int daestruct_input_stream_append_chunk(struct daestruct_input_stream* stream, int count,
+					  const int* variables, const int* equations, const int* derivatives) {
+    try {
+      for (int i = 0; i < count; i++)
+	stream->append(equations[i], variables[i], derivatives[i]);
+      return 0;
+    } catch (const std::exception&) {
+      return -1;
+    }
+  }
+
+  struct daestruct_input* daestruct_input_stream_build(struct daestruct_input_stream* stream) {
+    return static_cast<daestruct_input*>(new InputProblem(stream->build()));
+  }
+
+  void daestruct_input_stream_delete(struct daestruct_input_stream* stream) {
+    delete stream;
+  }
+
   void daestruct_input_push_back(struct daestruct_input* problem, int variable, int equation, int derivative) {
     problem->sigma.push_back(equation, variable, -derivative);
   }
@@ -64,8 +101,122 @@ extern "C" {
     delete problem;
   }
 
+  void daestruct_input_set_option(struct daestruct_input* problem, int option, int value) {
+    switch (option) {
+    case DAESTRUCT_KEEP_DUALS: 
+      problem->options.keep_duals = value != 0;
+      break;
+    case DAESTRUCT_THREADS:
+      problem->options.threads = value > 0 ? value : 0;
+      break;
+    case DAESTRUCT_OFFSETS:
+      problem->options.offsets = value ? OFFSETS_POTENTIALS : OFFSETS_FIXED_POINT;
+      break;
+    case DAESTRUCT_ENGINE:
+      problem->options.engine = value ? ENGINE_COST_SCALING : ENGINE_JONKER_VOLGENANT;
+      break;
+    }
+  }
+
+  /* analysis errors cannot cross the C boundary */
   struct daestruct_result* daestruct_analyse(struct daestruct_input* problem) {
-    return static_cast<daestruct_result*>(new AnalysisResult(problem->pryceAlgorithm()));
+    try {
+      return static_cast<daestruct_result*>(new AnalysisResult(problem->pryceAlgorithm()));
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+  }
+
+  /* file errors cannot cross the C boundary */
+  int daestruct_input_write_mapped(struct daestruct_input* problem, const char* path) {
+    try {
+      daestruct::mapped_sigma_matrix::write(problem->sigma, path);
+      return 0;
+    } catch (const std::exception&) {
+      return -1;
+    }
+  }
+
+  int daestruct_input_stream_write_mapped(struct daestruct_input_stream* stream, const char* path) {
+    try {
+      stream->write_mapped(path);
+      return 0;
+    } catch (const std::exception&) {
+      return -1;
+    }
+  }
+
+  struct daestruct_mapped* daestruct_mapped_open(const char* path) {
+    try {
+      return new daestruct_mapped(path);
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+  }
+
+  /* analysis errors cannot cross the C boundary */
+  struct daestruct_result* daestruct_mapped_analyse(struct daestruct_mapped* problem) {
+    try {
+      return static_cast<daestruct_result*>(new AnalysisResult(problem->pryceAlgorithm()));
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+  }
+
+  void daestruct_mapped_delete(struct daestruct_mapped* problem) {
+    delete problem;
+  }
+
+  struct daestruct_input* daestruct_input_read(const char* path) {
+    try {
+      return static_cast<daestruct_input*>(new InputProblem(read_problem(path)));
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+  }
+
+  int daestruct_input_write(struct daestruct_input* problem, const char* path) {
+    std::ofstream out(path);
+    write_matrix_market(problem->sigma, out);
+    out.close();
+    return out ? 0 : -1;
+  }
+
+  struct daestruct_cache* daestruct_cache_new(int capacity) {
+    return new daestruct_cache(std::max(capacity, 0));
+  }
+
+  void daestruct_cache_delete(struct daestruct_cache* cache) {
+    delete cache;
+  }
+
+  int daestruct_cache_hits(struct daestruct_cache* cache) {
+    return cache->hits;
+  }
+
+  int daestruct_cache_misses(struct daestruct_cache* cache) {
+    return cache->misses;
+  }
+
+  /* analysis errors cannot cross the C boundary */
+  struct daestruct_result* daestruct_analyse_cached(struct daestruct_input* problem, struct daestruct_cache* cache) {
+    try {
+      return static_cast<daestruct_result*>(new AnalysisResult(problem->pryceAlgorithm(*cache)));
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+  }
+
+  int daestruct_result_status(struct daestruct_result* result) {
+    return result->status;
+  }
+
+  int daestruct_result_augmentations(struct daestruct_result* result) {
+    return result->augmentations;
+  }
+
+  int daestruct_result_scanned_columns(struct daestruct_result* result) {
+    return result->scanned_columns;
   }
 
   int daestruct_result_equation_index(struct daestruct_result* result, int equation) {
@@ -76,10 +227,110 @@ extern "C" {
     return result->d[variable];
   }
 
+  int daestruct_result_dimension(struct daestruct_result* result) {
+    return result->c.size();
+  }
+
+  const int* daestruct_result_equation_indices(struct daestruct_result* result) {
+    return result->c.data();
+  }
+
+  const int* daestruct_result_variable_indices(struct daestruct_result* result) {
+    return result->d.data();
+  }
+
+  void daestruct_result_copy_equation_indices(struct daestruct_result* result, int* dst) {
+    std::copy(result->c.begin(), result->c.end(), dst);
+  }
+
+  void daestruct_result_copy_variable_indices(struct daestruct_result* result, int* dst) {
+    std::copy(result->d.begin(), result->d.end(), dst);
+  }
+
+  void daestruct_result_copy_row_assignment(struct daestruct_result* result, int* dst) {
+    std::copy(result->row_assignment.begin(), result->row_assignment.end(), dst);
+  }
+
+  void daestruct_result_copy_col_assignment(struct daestruct_result* result, int* dst) {
+    std::copy(result->col_assignment.begin(), result->col_assignment.end(), dst);
+  }
+
+  int daestruct_result_components(struct daestruct_result* result) {
+    return result->inflated.component_rows.size();
+  }
+
+  void daestruct_result_copy_component_offsets(struct daestruct_result* result, int* rows, int* cols) {
+    std::copy(result->inflated.component_rows.begin(), result->inflated.component_rows.end(), rows);
+    std::copy(result->inflated.component_cols.begin(), result->inflated.component_cols.end(), cols);
+  }
+
   void daestruct_result_delete(struct daestruct_result* result) {
     delete result;
   }
 
+  int daestruct_result_write(struct daestruct_result* result, const char* path) {
+    std::ofstream out(path);
+    write_matrix_market(*result, out);
+    out.close();
+    return out ? 0 : -1;
+  }
+
+  struct daestruct_reduced* daestruct_reduce(struct daestruct_input* problem, struct daestruct_result* result) {
+    try {
+      return new daestruct_reduced(reduce(problem->sigma, *result));
+    } catch (const std::invalid_argument&) {
+      return nullptr;
+    }
+  }
+
+  int daestruct_reduced_equations(struct daestruct_reduced* reduced) {
+    return reduced->equations();
+  }
+
+  int daestruct_reduced_variables(struct daestruct_reduced* reduced) {
+    return reduced->variables();
+  }
+
+  void daestruct_reduced_copy_starts(struct daestruct_reduced* reduced, int* equation_start, int* variable_start) {
+    std::copy(reduced->equation_start.begin(), reduced->equation_start.end(), equation_start);
+    std::copy(reduced->variable_start.begin(), reduced->variable_start.end(), variable_start);
+  }
+
+  int daestruct_reduced_nonzeros(struct daestruct_reduced* reduced) {
+    return reduced->columns.size();
+  }
+
+  void daestruct_reduced_copy_incidence(struct daestruct_reduced* reduced, int* row_start, int* columns) {
+    std::copy(reduced->row_start.begin(), reduced->row_start.end(), row_start);
+    std::copy(reduced->columns.begin(), reduced->columns.end(), columns);
+  }
+
+  int daestruct_reduced_blocks(struct daestruct_reduced* reduced) {
+    return reduced->blocks();
+  }
+
+  void daestruct_reduced_copy_blocks(struct daestruct_reduced* reduced, int* block_start, int* equations) {
+    std::copy(reduced->block_start.begin(), reduced->block_start.end(), block_start);
+    std::copy(reduced->block_equations.begin(), reduced->block_equations.end(), equations);
+  }
+
+  int daestruct_reduced_dummies(struct daestruct_reduced* reduced) {
+    return reduced->dummy_variables.size();
+  }
+
+  int daestruct_reduced_degrees_of_freedom(struct daestruct_reduced* reduced) {
+    return reduced->degrees_of_freedom();
+  }
+
+  void daestruct_reduced_copy_dummies(struct daestruct_reduced* reduced, int* variables, int* orders) {
+    std::copy(reduced->dummy_variables.begin(), reduced->dummy_variables.end(), variables);
+    std::copy(reduced->dummy_orders.begin(), reduced->dummy_orders.end(), orders);
+  }
+
+  void daestruct_reduced_delete(struct daestruct_reduced* reduced) {
+    delete reduced;
+  }
+
   struct daestruct_component_builder* daestruct_component_builder_create(int publics, int privates) {
     return static_cast<struct daestruct_component_builder*>
       (new compressible_builder(publics, privates));
@@ -126,8 +377,13 @@ extern "C" {
     delete list;
   }
 
+  /* analysis errors cannot cross the C boundary */
   struct daestruct_result* daestruct_analyse_compressed(struct daestruct_input* problem, struct daestruct_component_list* list) {
-    return static_cast<struct daestruct_result*>(new AnalysisResult(problem->pryceCompressed(*list)));
+    try {
+      return static_cast<struct daestruct_result*>(new AnalysisResult(problem->pryceCompressed(*list)));
+    } catch (const std::exception&) {
+      return nullptr;
+    }
   }
 
 }
@@ -39,8 +39,14 @@
 #include <iostream>
 #include <algorithm>
 #include <boost/heap/d_ary_heap.hpp>
+#include <memory>
+#include <numeric>
+#include <thread>
 #include <boost/timer/timer.hpp>
 #include "lap.hpp"
+#include "row_kernels.hpp"
+#include "barrier.hpp"
+#include <daestruct/mapped_sigma_matrix.hpp>
 #include "prettyprint.hpp"
 
 /**
@@ -62,19 +68,41 @@ struct node_compare {
 /* our priority queue, lent from boost with our custom comparator */
 typedef boost::heap::d_ary_heap<int,  boost::heap::arity<4>, boost::heap::mutable_<true>, boost::heap::compare<node_compare>> priority_queue;
 
+/* the state of a column during the search for an augmenting path */
+enum column_state : char {
+  UNREACHED, /* not seen yet */
+  TODO,      /* reached, in the priority queue */
+  SCAN,      /* distance is minimal, waiting to be scanned */
+  READY      /* scanned */
+};
+
 struct augmentation_data {
-  /* is a column in "todo"? */
-  std::vector<bool> in_todo;
+  /* state of each column */
+  std::vector<char> state;
+
+  /* columns that are not UNREACHED, to reset only those */
+  std::vector<int> reached;
+  
+  /* rows of the last augmenting path, starting at its end */
+  std::vector<int> path;
+
+  /* cost change of the last augmentation */
+  int cost_change = 0;
+
+  /* length of the last shortest augmenting path (in reduced costs) */
+  int length = 0;
   
   /* vector of 'ready' columns */
   std::vector<int> ready;
-  std::vector<bool> is_ready;
 
   /* vector of previous rows for each column in the augmenting path */
   std::vector<int> prev;
 
   /* scan vector */
   std::vector<int> scan;
+
+  /* reduced costs of the row being scanned */
+  std::vector<int> reduced;
   
   /* comparator implementation, based on distances */
   std::vector<int> dist;
@@ -84,56 +112,89 @@ struct augmentation_data {
   node_compare cmp;
   priority_queue pq;
 
-  augmentation_data(int dim) : in_todo(dim), is_ready(dim), prev(dim), dist(dim), handles(dim), cmp(&dist), pq(cmp) {
+  /* rows of the depth-first search of a phase and the next entry to try in each */
+  std::vector<size_t> stack;
+  std::vector<size_t> next;
+
+  augmentation_data(int dim) : state(dim), prev(dim), dist(dim), handles(dim), cmp(&dist), pq(cmp), next(dim) {
     pq.reserve(dim);
   }
 
-  void reset(int start) {
-    std::fill(is_ready.begin(), is_ready.end(), false);
-    std::fill(in_todo.begin(), in_todo.end(), false);
-    std::fill(prev.begin(), prev.end(), start);
+  /* costs O(columns reached by the last search), not O(dim) */
+  void reset() {
+    for (const int j : reached)
+      state[j] = UNREACHED;
+    reached.clear();
 
     pq.clear();
     ready.clear();
     scan.clear();
+    path.clear();
+    cost_change = 0;
   }
 };
 
-inline void augment(augmentation_data& data, const daestruct::sigma_matrix& assigncost, std::vector<int>& v, const int start, std::vector<size_t>& rowsol, std::vector<size_t>& colsol) {
-  data.reset(start);
+/**
+ * The reduced costs cost(i,j) - v[j] of a row, in the order of its entries
+ */
+template<class Row>
+inline const int* reduce_row(std::vector<int>& buffer, const Row& row, const std::vector<int>& v) {
+  const size_t n = row.nnz();
+  if (buffer.size() < n)
+    buffer.resize(n);
+  daestruct::kernels::reduced_costs(daestruct::kernels::entries(row), n, v.data(), buffer.data());
+  return buffer.data();
+}
 
-  const daestruct::sigma_matrix::row_t& start_row = assigncost.rows().at(start);
+/**
+ * Find a shortest augmenting path starting in row 'start', without changing anything.
+ * Returns the free column at its end, or -1 if there is no such path, i.e. if the 
+ * cost matrix is structurally singular. The path and the price change are left in data,
+ * they depend on the prices of the reached columns and the rows assigned to them only.
+ */
+template<class Matrix>
+inline int shortest_path(augmentation_data& data, const Matrix& assigncost, const std::vector<int>& v, const int start, 
+			 const std::vector<daestruct::index_t>& colsol) {
+  data.reset();
+
+  const auto& start_row = assigncost.row(start);
+  const int* reduced = reduce_row(data.reduced, start_row, v);
 
   /* iterate twice to get correct order in queue */
-  for (auto col = start_row.begin(); col != start_row.end() ; col++)
-    data.dist[col.index()] = (*col) - v[col.index()];
+  size_t k = 0;
+  for (auto col = start_row.begin(); col != start_row.end() ; col++, k++)
+    data.dist[col.index()] = reduced[k];
 
   for (auto col = start_row.begin(); col != start_row.end() ; col++) {
     data.handles[col.index()] = data.pq.push(col.index());
-    data.in_todo[col.index()] = true;
+    data.state[col.index()] = TODO;
+    data.prev[col.index()] = start;
+    data.reached.push_back(col.index());
   }  
 
-  int endofpath = -1;
   int min = 0;
-  int iter = 0;
   do {
-    iter++;
     if (data.scan.empty()) {
-      while (!data.pq.empty() && !data.in_todo[data.pq.top()])
+      while (!data.pq.empty() && data.state[data.pq.top()] != TODO)
 	data.pq.pop();
-      const size_t dd = data.pq.top();
-      min = data.dist[dd];
+
+      /* every reachable column is assigned: no augmenting path */
+      if (data.pq.empty())
+	return -1;
+
+      min = data.dist[data.pq.top()];
       while(!data.pq.empty() && data.dist[data.pq.top()] == min) {
 	const int j = data.pq.top();
-	if (data.in_todo[j]) {
-	  if (colsol[j] > colsol.size()) {
-	    endofpath = j;
-	    goto augment;
-	  }
-	  data.scan.push_back(j);
-	  data.in_todo[j] = false;
-	  data.pq.pop();
+	data.pq.pop();
+	if (data.state[j] != TODO)
+	  continue;
+
+	if (colsol[j] >= colsol.size()) {
+	  data.length = min;
+	  return j;
 	}
+	data.scan.push_back(j);
+	data.state[j] = SCAN;
       }
     }
 
@@ -141,33 +202,40 @@ inline void augment(augmentation_data& data, const daestruct::sigma_matrix& assi
     data.scan.pop_back();
     const int i = colsol[j1];
     data.ready.push_back(j1);
-    data.is_ready[j1] = true;
+    data.state[j1] = READY;
 
-    const daestruct::sigma_matrix::row_t& row = assigncost.rows().at(i);
+    const auto& row = assigncost.row(i);
     const int h = assigncost(i, j1) - v[j1];
+    const int* reduced = reduce_row(data.reduced, row, v);
     //sparse version of: forall j in TODO
-    for (auto col = row.begin(); col != row.end() ; col++) {
+    size_t k = 0;
+    for (auto col = row.begin(); col != row.end() ; col++, k++) {
       const int j = col.index();
-      if (data.is_ready[j])
+      if (data.state[j] == READY || data.state[j] == SCAN)
 	continue;
 
-      const int c_red = *col - v[j] - h;
-      if (!data.in_todo[j] || min + c_red < data.dist[j]) {
+      const int c_red = reduced[k] - h;
+      if (data.state[j] == UNREACHED || min + c_red < data.dist[j]) {
 	data.dist[j] = min + c_red;
 	data.prev[j] = i;
+	if (data.state[j] == UNREACHED)
+	  data.reached.push_back(j);
 	
 	if (0 == c_red) {
-	  if (colsol[j] > colsol.size()) {
-	    endofpath = j;
-	    goto augment;
+	  if (colsol[j] >= colsol.size()) {
+	    data.length = min;
+	    return j;
 	  } else {
+	    /* keep the queue consistent, the entry is skipped when popped */
+	    if (data.state[j] == TODO)
+	      data.pq.update(data.handles[j]);
 	    data.scan.push_back(j);
-	    data.in_todo[j] = false;	    
+	    data.state[j] = SCAN;
 	  }
 	} else {
-	  if (!data.in_todo[j]) {
+	  if (data.state[j] == UNREACHED) {
 	    data.handles[j] = data.pq.push(j);
-	    data.in_todo[j] = true;
+	    data.state[j] = TODO;
 	  } else {
 	    data.pq.update(data.handles[j]);
 	  }
@@ -176,11 +244,18 @@ inline void augment(augmentation_data& data, const daestruct::sigma_matrix& assi
     }
 
   } while(true);
-  
- augment:
+}
+
+/**
+ * Augment along the path found by shortest_path() from row 'start' to the free column 'endofpath'
+ * This changes the prices of the columns in data.ready and the assignment of the columns on the path.
+ */
+template<class Matrix>
+inline void apply_path(augmentation_data& data, const Matrix& assigncost, std::vector<int>& v, const int start, int endofpath,
+		       std::vector<daestruct::index_t>& rowsol, std::vector<daestruct::index_t>& colsol) {
   /* update column prices */
   for (const int j : data.ready) {
-    v[j] = v[j] + data.dist[j] - min;
+    v[j] = v[j] + data.dist[j] - data.length;
   }
   
   /* augment solution */
@@ -191,97 +266,623 @@ inline void augment(augmentation_data& data, const daestruct::sigma_matrix& assi
     const int j1 = endofpath; 
     endofpath = rowsol[i]; 
     rowsol[i] = j1;
+
+    data.path.push_back(i);
+    data.cost_change += assigncost(i, j1);
+    /* the start row may still point to a column it lost earlier */
+    if (i != start)
+      data.cost_change -= assigncost(i, endofpath);
   }
   while(i != start);
 }
 
+/**
+ * Find a shortest augmenting path starting in row 'start' and augment along it.
+ * Returns false (and leaves everything untouched) if no such path exists, 
+ * i.e. if the cost matrix is structurally singular.
+ */
+template<class Matrix>
+inline bool augment(augmentation_data& data, const Matrix& assigncost, std::vector<int>& v, const int start, 
+		    std::vector<daestruct::index_t>& rowsol, std::vector<daestruct::index_t>& colsol) {
+  const int endofpath = shortest_path(data, assigncost, v, start, colsol);
+  if (endofpath < 0)
+    return false;
+  apply_path(data, assigncost, v, start, endofpath, rowsol, colsol);
+  return true;
+}
+
+/* 
+ * The augmentation switches from single rows to phases when the remaining rows 
+ * would scan more than phase_work * dim columns at the recent cost of a search
+ * (averaged over about search_window searches)
+ */
+static const size_t phase_work = 16;
+static const size_t search_window = 16;
+
+/**
+ * One phase of the augmentation of all free rows at once (Hungarian method):
+ * A Dijkstra forest grown from all free rows finds the length of the shortest
+ * augmenting path, the prices change such that every shortest augmenting path 
+ * is tight (zero reduced costs) and a maximal set of vertex-disjoint tight 
+ * augmenting paths is augmented.
+ * u holds the duals of the free rows, free the rows that are still free afterwards.
+ * Returns the number of augmentations, 0 iff none of the free rows can be assigned.
+ */
+template<class Matrix>
+inline size_t augment_phase(augmentation_data& data, const Matrix& assigncost, std::vector<int>& u, std::vector<int>& v,
+			    std::vector<size_t>& free, std::vector<daestruct::index_t>& rowsol, std::vector<daestruct::index_t>& colsol) {
+  const size_t dim = colsol.size();
+  data.reset();
+
+  for (const size_t i : free) {
+    const auto& row = assigncost.row(i);
+    const int* reduced = reduce_row(data.reduced, row, v);
+    u[i] = *std::min_element(reduced, reduced + row.nnz());
+
+    size_t k = 0;
+    for (auto col = row.begin(); col != row.end(); col++, k++) {
+      const int j = col.index();
+      const int d = reduced[k] - u[i];
+      if (data.state[j] == UNREACHED) {
+	data.dist[j] = d;
+	data.handles[j] = data.pq.push(j);
+	data.state[j] = TODO;
+	data.reached.push_back(j);
+      } else if (d < data.dist[j]) {
+	data.dist[j] = d;
+	data.pq.update(data.handles[j]);
+      }
+    }
+  }
+
+  /* the forest, up to the first free column */
+  int shortest = -1;
+  while (!data.pq.empty()) {
+    const int j1 = data.pq.top();
+    data.pq.pop();
+    if (colsol[j1] >= dim) {
+      shortest = data.dist[j1];
+      break;
+    }
+    data.state[j1] = READY;
+    data.ready.push_back(j1);
+
+    const int i = colsol[j1];
+    const auto& row = assigncost.row(i);
+    const int h = assigncost(i, j1) - v[j1];
+    const int* reduced = reduce_row(data.reduced, row, v);
+    size_t k = 0;
+    for (auto col = row.begin(); col != row.end(); col++, k++) {
+      const int j = col.index();
+      if (data.state[j] == READY)
+	continue;
+      const int d = data.dist[j1] + reduced[k] - h;
+      if (data.state[j] == UNREACHED) {
+	data.dist[j] = d;
+	data.handles[j] = data.pq.push(j);
+	data.state[j] = TODO;
+	data.reached.push_back(j);
+      } else if (d < data.dist[j]) {
+	data.dist[j] = d;
+	data.pq.update(data.handles[j]);
+      }
+    }
+  }
+  if (shortest < 0)
+    return 0;
+
+  /* afterwards every shortest augmenting path is tight */
+  for (const int j : data.ready)
+    v[j] = v[j] + data.dist[j] - shortest;
+  for (const size_t i : free)
+    u[i] += shortest;
+
+  /* 
+   * vertex-disjoint tight paths, depth-first from every free row without recursion 
+   * (a column is entered once, then marked SCAN). The searches fail only if none of
+   * them augments, but the free column settled above is reached by a tight path.
+   */
+  size_t augmented = 0;
+  std::vector<size_t>& stack = data.stack;
+  std::vector<size_t>& next = data.next;
+  for (const size_t f : free) {
+    stack.assign(1, f);
+    next[f] = 0;
+    while (!stack.empty()) {
+      const size_t i = stack.back();
+      const auto& row = assigncost.row(i);
+      const auto* entries = daestruct::kernels::entries(row);
+      if (next[i] == row.nnz()) {
+	stack.pop_back();
+	continue;
+      }
+
+      const auto& e = entries[next[i]++];
+      const int j = daestruct::kernels::column_of(e);
+      if (data.state[j] == SCAN || daestruct::kernels::cost_of(e) - v[j] != u[i])
+	continue;
+      if (data.state[j] == UNREACHED)
+	data.reached.push_back(j);
+      data.state[j] = SCAN;
+
+      if (colsol[j] >= dim) {
+	/* every row on the stack takes the column it left through */
+	for (const size_t r : stack) {
+	  const int c = daestruct::kernels::column_of(daestruct::kernels::entries(assigncost.row(r))[next[r] - 1]);
+	  rowsol[r] = c;
+	  colsol[c] = r;
+	}
+	augmented++;
+	break;
+      }
+
+      const size_t i2 = colsol[j];
+      u[i2] = assigncost(i2, j) - v[j];
+      next[i2] = 0;
+      stack.push_back(i2);
+    }
+  }
+
+  free.erase(std::remove_if(free.begin(), free.end(), [&](size_t i) { return rowsol[i] < dim; }), free.end());
+  return augmented;
+}
+
+/**
+ * Augment the free rows by speculative searches on several threads: In every round each
+ * thread searches a shortest augmenting path for another free row on the same prices and
+ * assignment. Then the paths are applied in the order of the threads, a path is still
+ * a shortest one if none of the columns its search reached was changed by a path applied
+ * before it in the round. The other rows are searched again (serially, in data).
+ * Returns the number of repeated searches.
+ */
+template<class Matrix>
+static size_t augment_speculatively(augmentation_data& data, const Matrix& assigncost, std::vector<int>& v, 
+				    const size_t* free, const size_t numfree, std::vector<daestruct::index_t>& rowsol, 
+				    std::vector<daestruct::index_t>& colsol, size_t& scanned_columns, const unsigned threads) {
+  const size_t dim = colsol.size();
+  std::vector<std::unique_ptr<augmentation_data>> local(threads);
+  for (auto& l : local)
+    l.reset(new augmentation_data(dim));
+  std::vector<int> ends(threads);
+
+  /* the round in which a column was last changed */
+  std::vector<size_t> changed_in(dim, numfree);
+  size_t repeated = 0;
+
+  /* 
+   * every thread takes the rows of one chunk of the free rows, neighbouring rows tend to 
+   * be neighbours in the model and their searches would conflict more often
+   */
+  const size_t chunk = (numfree + threads - 1) / threads;
+
+  /* the threads search, then the first one applies the paths while the others wait */
+  daestruct::barrier round(threads);
+  auto work = [&](unsigned w) {
+    for (size_t r = 0; r < chunk; r++) {
+      if (w * chunk + r < numfree)
+	ends[w] = shortest_path(*local[w], assigncost, v, free[w * chunk + r], colsol);
+      round.wait();
+
+      for (unsigned k = 0; w == 0 && k < threads && k * chunk + r < numfree; k++) {
+	const size_t i = free[k * chunk + r];
+	augmentation_data* search = local[k].get();
+	int end = ends[k];
+	if (std::any_of(search->reached.begin(), search->reached.end(), [&](int j) { return changed_in[j] == r; })) {
+	  repeated++;
+	  search = &data;
+	  end = shortest_path(data, assigncost, v, i, colsol);
+	}
+	scanned_columns += search->ready.size();
+
+	// a row de-assigned earlier may still point to its old column.
+	if (end < 0) {
+	  rowsol[i] = BIG;
+	  continue;
+	}
+	apply_path(*search, assigncost, v, i, end, rowsol, colsol);
+	for (const int j : search->ready)
+	  changed_in[j] = r;
+	changed_in[end] = r;
+      }
+      round.wait();
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned w = 1; w < threads; w++)
+    workers.emplace_back(work, w);
+  work(0);
+  for (auto& worker : workers)
+    worker.join();
+
+  return repeated;
+}
+
+/**
+ * Karp-Sipser matching of the tight entries, i.e. those with the smallest reduced cost 
+ * cost(i,j) - v[j] of their row: A row or column with a single unmatched tight neighbour 
+ * is matched to it (which never makes the matching smaller), otherwise the first unmatched
+ * row takes its first unmatched tight column. Any matching of tight entries is consistent 
+ * with the prices v, so it can be augmented like the one of the column reduction.
+ * Returns the number of matched rows, all in O(nonzeros).
+ */
+template<class Matrix>
+static size_t karp_sipser(const Matrix& assigncost, const std::vector<int>& v,
+			  std::vector<daestruct::index_t>& rowsol, std::vector<daestruct::index_t>& colsol) {
+  const size_t dim = colsol.size();
+
+  /* the tight entries by rows and by columns */
+  std::vector<size_t> row_start(dim + 1), col_start(dim + 1);
+  std::vector<daestruct::index_t> row_tight, col_tight;
+  std::vector<int> reduced;
+  for (size_t i = 0; i < dim; i++) {
+    const auto& row = assigncost.row(i);
+    const auto* entries = daestruct::kernels::entries(row);
+    const int* h = reduce_row(reduced, row, v);
+    const int* smallest = std::min_element(h, h + row.nnz());
+    for (size_t k = 0; k < row.nnz(); k++)
+      if (h[k] == *smallest) {
+	row_tight.push_back(daestruct::kernels::column_of(entries[k]));
+	col_start[daestruct::kernels::column_of(entries[k]) + 1]++;
+      }
+    row_start[i + 1] = row_tight.size();
+  }
+  std::partial_sum(col_start.begin(), col_start.end(), col_start.begin());
+  col_tight.resize(row_tight.size());
+  {
+    std::vector<size_t> fill(col_start.begin(), col_start.end() - 1);
+    for (size_t i = 0; i < dim; i++)
+      for (size_t e = row_start[i]; e < row_start[i + 1]; e++)
+	col_tight[fill[row_tight[e]]++] = i;
+  }
+
+  /* unmatched tight neighbours and the rows and columns that have a single one */
+  std::vector<size_t> row_degree(dim), col_degree(dim);
+  std::vector<size_t> single_rows, single_cols;
+  for (size_t i = 0; i < dim; i++) {
+    row_degree[i] = row_start[i + 1] - row_start[i];
+    if (row_degree[i] == 1)
+      single_rows.push_back(i);
+    col_degree[i] = col_start[i + 1] - col_start[i];
+    if (col_degree[i] == 1)
+      single_cols.push_back(i);
+  }
+
+  size_t matched = 0;
+  auto match = [&](size_t i, size_t j) {
+    rowsol[i] = j;
+    colsol[j] = i;
+    matched++;
+    for (size_t e = row_start[i]; e < row_start[i + 1]; e++)
+      if (colsol[row_tight[e]] >= dim && --col_degree[row_tight[e]] == 1)
+	single_cols.push_back(row_tight[e]);
+    for (size_t e = col_start[j]; e < col_start[j + 1]; e++)
+      if (rowsol[col_tight[e]] >= dim && --row_degree[col_tight[e]] == 1)
+	single_rows.push_back(col_tight[e]);
+  };
+
+  size_t next_row = 0;
+  while (true) {
+    if (!single_cols.empty()) {
+      const size_t j = single_cols.back();
+      single_cols.pop_back();
+      for (size_t e = col_start[j]; colsol[j] >= dim && e < col_start[j + 1]; e++)
+	if (rowsol[col_tight[e]] >= dim)
+	  match(col_tight[e], j);
+      continue;
+    }
+
+    size_t i;
+    if (!single_rows.empty()) {
+      i = single_rows.back();
+      single_rows.pop_back();
+    } else {
+      while (next_row < dim && (rowsol[next_row] < dim || row_degree[next_row] == 0))
+	next_row++;
+      if (next_row == dim)
+	break;
+      i = next_row;
+    }
+
+    for (size_t e = row_start[i]; rowsol[i] >= dim && e < row_start[i + 1]; e++)
+      if (colsol[row_tight[e]] >= dim)
+	match(i, row_tight[e]);
+  }
+
+  return matched;
+}
+
+/* absent entries of the dense matrices, far above any path length */
+static const int dense_absent = INT_MAX / 4;
+
+/**
+ * The LAP of a matrix of dimension <= N as a dense N x N matrix (absent entries and the 
+ * padding cost dense_absent): After a column reduction, shortest augmenting paths for the 
+ * free rows, by Dijkstra over whole rows of fixed length without a heap, which the compiler
+ * unrolls and vectorizes.
+ * Returns false (and leaves sol untouched) if some row has no augmenting path, i.e. if 
+ * the matrix is structurally singular, that is left to the sparse lap().
+ */
+template<size_t N, class Matrix>
+static bool dense_lap(const Matrix& assigncost, solution& sol) {
+  const size_t n = assigncost.dimension();
+  alignas(64) int cost[N][N];
+  alignas(64) int v[N], dist[N], open[N], pred[N];
+  int rowsol[N], colsol[N];
+
+  for (size_t i = 0; i < N; i++) {
+    for (size_t j = 0; j < N; j++)
+      cost[i][j] = dense_absent;
+    v[i] = 0;
+    rowsol[i] = colsol[i] = -1;
+  }
+  for (size_t i = 0; i < n; i++) {
+    const auto& row = assigncost.row(i);
+    const auto* entries = daestruct::kernels::entries(row);
+    for (size_t k = 0; k < row.nnz(); k++)
+      cost[i][daestruct::kernels::column_of(entries[k])] = daestruct::kernels::cost_of(entries[k]);
+  }
+
+  /* column reduction: every column goes to its cheapest row, if that one is still free */
+  size_t initialized = 0;
+  for (size_t j = 0; j < n; j++) {
+    size_t imin = 0;
+    for (size_t i = 1; i < n; i++)
+      imin = cost[i][j] < cost[imin][j] ? i : imin;
+    if (cost[imin][j] == dense_absent)
+      continue;
+    v[j] = cost[imin][j];
+    if (rowsol[imin] < 0) {
+      rowsol[imin] = j;
+      colsol[j] = imin;
+      initialized++;
+    }
+  }
+
+  size_t scanned_columns = 0, searches = 0;
+  int ready[N];
+  for (size_t f = 0; f < n; f++) {
+    if (rowsol[f] >= 0)
+      continue;
+    searches++;
+
+    for (size_t j = 0; j < N; j++) {
+      dist[j] = cost[f][j] - v[j];
+      open[j] = -1;
+      pred[j] = f;
+    }
+
+    size_t numready = 0;
+    int endofpath;
+    while (true) {
+      int min = INT_MAX;
+      for (size_t j = 0; j < N; j++)
+	min = std::min(min, open[j] ? dist[j] : INT_MAX);
+      if (min >= dense_absent / 2)
+	return false;
+      size_t j1 = 0;
+      while (!open[j1] || dist[j1] != min)
+	j1++;
+
+      if (colsol[j1] < 0) {
+	endofpath = j1;
+	break;
+      }
+      open[j1] = 0;
+      ready[numready++] = j1;
+
+      /* dist[j] = min(dist[j], min + reduced cost of (i, j) - reduced cost of (i, j1)) */
+      const int i = colsol[j1];
+      const int h = min - (cost[i][j1] - v[j1]);
+      for (size_t j = 0; j < N; j++) {
+	const int d = h + cost[i][j] - v[j];
+	const bool shorter = open[j] & (d < dist[j]);
+	dist[j] = shorter ? d : dist[j];
+	pred[j] = shorter ? i : pred[j];
+      }
+    }
+    scanned_columns += numready;
+
+    for (size_t k = 0; k < numready; k++)
+      v[ready[k]] += dist[ready[k]] - dist[endofpath];
+
+    int i;
+    do {
+      i = pred[endofpath];
+      colsol[endofpath] = i;
+      std::swap(endofpath, rowsol[i]);
+    } while (i != static_cast<int>(f));
+  }
+
+  sol.rowsol.resize(n);
+  sol.colsol.resize(n);
+  sol.u.resize(n);
+  sol.v.assign(v, v + n);
+  sol.cost = 0;
+  for (size_t i = 0; i < n; i++) {
+    sol.rowsol[i] = rowsol[i];
+    sol.colsol[i] = colsol[i];
+    sol.u[i] = cost[i][rowsol[i]] - v[rowsol[i]];
+    sol.cost += cost[i][rowsol[i]];
+  }
+  sol.unassigned = 0;
+  sol.augmentations = searches;
+  sol.scanned_columns = scanned_columns;
+  sol.initialized_rows = initialized;
+  sol.augmented_rows = n - initialized;
+  return true;
+}
+
 std::ostream& operator<<(std::ostream& o, const solution& s) {
   o << "solution " << 
     "{ cost=" << s.cost << 
     ", rowsol=" << s.rowsol << 
     ", colsol=" << s.colsol <<
     ", u=" << s.u <<
-    ", v=" << s.v << "}";
+    ", v=" << s.v << 
+    ", unassigned=" << s.unassigned << "}";
   return o;
 }
 
 solution delta_lap(const daestruct::sigma_matrix& assigncost, const std::vector<int>& _u, const std::vector<int>& _v,
-		   const std::vector<size_t>& _rowsol, const std::vector<size_t>& _colsol) {
-  //boost::timer::auto_cpu_timer t;
+		   const std::vector<daestruct::index_t>& _rowsol, const std::vector<daestruct::index_t>& _colsol) {
   const size_t dim = assigncost.dimension();
-  std::vector<int> u(dim),v(dim);
+  std::vector<int> u(dim), v(_v);
+  std::vector<daestruct::index_t> colsol(_colsol), rowsol(_rowsol);
 
-  size_t numfree = 0;
-  size_t* free = new size_t[dim];       // list of unassigned rows.
-  int* d = new int[dim];                // 'cost-distance' in augmenting path calculation.
-  size_t* pred = new size_t[dim];       // row-predecessor of column in augmenting/alternating path.
+  /* price the unassigned columns by their cheapest reduced cost over the assigned rows,
+     absent entries and free rows do not bound the price */
+  std::vector<bool> bounded(dim);
+  for (size_t j = 0; j < dim; j++)
+    if (colsol[j] >= dim)
+      v[j] = 0;
 
-  std::vector<size_t> colsol(_colsol), rowsol(_rowsol); //TODO avoid this copying?
+  for (size_t i = 0; i < dim; i++) {
+    if (rowsol[i] >= dim)
+      continue;
+    const daestruct::sigma_matrix::row_t& row = assigncost.row(i);
+    for (auto col = row.begin(); col != row.end(); col++) {
+      const size_t j = col.index();
+      if (colsol[j] < dim)
+	continue;
+      if (!bounded[j] || *col - _u[i] < v[j]) {
+	v[j] = *col - _u[i];
+	bounded[j] = true;
+      }
+    }
+  }
 
-  for (size_t j = 0; j < dim; j++) {
-    const size_t i = colsol[j];
-    if (i < dim) {
-      v[j] = _v[j];
-    } else {
-      v[j] = BIG;
-      for (size_t i2 = 0; i2 < dim; i2++)
-	v[j] = std::min(v[j], assigncost(i2, j) - _u[i2]);
+  /* make u and the cost match the given assignment */
+  int cost = 0;
+  for (size_t i = 0; i < dim; i++) {
+    const size_t j = rowsol[i];
+    if (j < dim) {
+      u[i] = assigncost(i, j) - v[j];
+      cost += assigncost(i, j);
     }
   }
 
-  for (size_t i = 0; i < _rowsol.size(); i++)
-    if (_rowsol[i] >= dim) 
-      free[numfree++] = i;
+  return delta_lap(assigncost, std::move(u), std::move(v), std::move(rowsol), std::move(colsol), cost);
+}
 
-  /*
-  std::cout << "Running delta analysis on " << numfree << " unassigned rows" << std::endl;
-  std::cout << _rowsol << std::endl;
-  std::cout << _colsol << std::endl;
-  std::cout << u << std::endl;
-  std::cout << v << std::endl;  
-  */
+solution delta_lap(const daestruct::sigma_matrix& assigncost, std::vector<int>&& u, std::vector<int>&& v,
+		   std::vector<daestruct::index_t>&& rowsol, std::vector<daestruct::index_t>&& colsol, int cost,
+		   const lap_options& options) {
+  const size_t dim = assigncost.dimension();
+  std::vector<daestruct::index_t> free;             // list of unassigned rows.
+  for (size_t i = 0; i < dim; i++)
+    if (rowsol[i] >= dim) 
+      free.push_back(i);
 
-  // AUGMENT SOLUTION for each free row.
-  augmentation_data data(assigncost.dimension());
-  for (size_t f = 0; f < numfree; f++) {
-    augment(data, assigncost, v, free[f], rowsol, colsol);
+  return delta_lap(assigncost, std::move(u), std::move(v), std::move(rowsol), std::move(colsol), cost, free, options);
+}
+
+/**
+ * The search state of delta_lap(), kept per thread so that a call does not pay O(dim)
+ * for allocating and clearing it. It only grows, touched is false but for touched_rows.
+ */
+struct delta_workspace {
+  std::unique_ptr<augmentation_data> data;
+  std::vector<bool> touched;
+  std::vector<size_t> touched_rows;
+
+  augmentation_data& reserve(size_t dim) {
+    /* the comparator points into data, so it is replaced, never copied */
+    if (!data || data->state.size() < dim)
+      data.reset(new augmentation_data(dim));
+    if (touched.size() < dim)
+      touched.resize(dim);
+    return *data;
   }
+};
 
-  // calculate optimal cost.
-  int lapcost = 0;
-  for (size_t i = 0; i < rowsol.size(); i++) {
-    const size_t j = rowsol[i];
-    //std::cout << "u[" << i << "] = " << "assigncost(" << i << "," << j << ") - v[" << j << "] = " <<  assigncost(i,j) << " - " << v[j] << std::endl;
-    u[i] = assigncost(i,j) - v[j];
-    lapcost = lapcost + assigncost(i,j); 
+solution delta_lap(const daestruct::sigma_matrix& assigncost, std::vector<int>&& u, std::vector<int>&& v,
+		   std::vector<daestruct::index_t>&& rowsol, std::vector<daestruct::index_t>&& colsol, int cost,
+		   const std::vector<daestruct::index_t>& free, const lap_options& options) {
+  //boost::timer::auto_cpu_timer t;
+  const size_t dim = assigncost.dimension();
+  static thread_local delta_workspace workspace;
+  augmentation_data& data = workspace.reserve(dim);
+
+  /* rows whose u needs to be recalculated, those of the last call are cleared first */
+  std::vector<bool>& touched = workspace.touched;
+  std::vector<size_t>& touched_rows = workspace.touched_rows;
+  for (const size_t i : touched_rows)
+    touched[i] = false;
+  touched_rows.clear();
+  auto touch = [&](size_t i) {
+    if (!touched[i]) {
+      touched[i] = true;
+      touched_rows.push_back(i);
+    }
+  };
+
+  // AUGMENT SOLUTION for each free row.
+  size_t unassigned = 0;
+  size_t augmentations = 0, scanned_columns = 0;
+  for (const size_t f : free) {
+    /* once cancelled, the remaining free rows stay unassigned */
+    const bool searched = !options.cancelled();
+    const bool augmented = searched && augment(data, assigncost, v, f, rowsol, colsol);
+    if (searched) {
+      augmentations++;
+      scanned_columns += data.ready.size();
+    }
+    if (!augmented) {
+      rowsol[f] = BIG;
+      u[f] = 0;
+      unassigned++;
+      continue;
+    }
+
+    cost += data.cost_change;
+    /* the path changed its assignments, the scanned columns their price */
+    for (const int i : data.path)
+      touch(i);
+    for (const int j : data.ready)
+      touch(colsol[j]);
   }
 
-  // free reserved memory.
-  delete[] pred;
-  delete[] free;
-  delete[] d;
+  for (const size_t i : touched_rows) 
+    if (rowsol[i] < dim)
+      u[i] = assigncost(i, rowsol[i]) - v[rowsol[i]];
 
   solution sol;
   sol.u = std::move(u);
   sol.v = std::move(v);
   sol.rowsol = std::move(rowsol);
   sol.colsol = std::move(colsol);
-  sol.cost = lapcost;
+  sol.cost = cost;
+  sol.unassigned = unassigned;
+  sol.augmentations = augmentations;
+  sol.scanned_columns = scanned_columns;
 
   //std::cout << "finished delta assignment" << std::endl;
   return sol;
 }
 
-solution lap(const daestruct::sigma_matrix& assigncost) {
+/**
+ * The LAP for any row-wise matrix with the read interface of sigma_matrix
+ */
+template<class Matrix>
+static solution lap_impl(const Matrix& assigncost, const lap_options& options) {
   const size_t dim = assigncost.dimension();
+
+  // tiny matrices are solved densely, without the setup of the sparse version.
+  solution dense;
+  if (options.dense_small_matrices && dim > 0 && dim <= 32 &&
+      (dim <= 8 ? dense_lap<8>(assigncost, dense) : dim <= 16 ? dense_lap<16>(assigncost, dense) : dense_lap<32>(assigncost, dense)))
+    return dense;
+
   boost::timer::auto_cpu_timer t;
   
   std::vector<int> u(dim),v(dim);
-  std::vector<size_t> rowsol(dim), colsol(dim);
+  std::vector<daestruct::index_t> rowsol(dim, BIG), colsol(dim, BIG);
   
   size_t  i, imin, numfree = 0, prvnumfree, f, i0, k, *pred, *free;
   size_t  j, j1, j2=0, *matches;  
-  size_t min=0, h, umin, usubmin, *d;
+  int min=0, umin, usubmin=0;
+  size_t *d;
 
   free = new size_t[dim];      // list of unassigned rows.
   matches = new size_t[dim](); // counts how many times a row could be assigned.
@@ -293,7 +894,16 @@ solution lap(const daestruct::sigma_matrix& assigncost) {
   {
     // find minimum cost over rows.
     imin = assigncost.smallest_cost_row(j);
-    v[j] = assigncost(imin,j); 
+    const daestruct::der_t* c_min = assigncost.find_element(imin, j);
+    if (!c_min) {
+      // empty column, can never be assigned.
+      v[j] = 0;
+      continue;
+    }
+    v[j] = *c_min; 
+
+    if (options.initialization == INIT_KARP_SIPSER)
+      continue;               // assigned below.
 
     if (++matches[imin] == 1) 
     { 
@@ -305,9 +915,17 @@ solution lap(const daestruct::sigma_matrix& assigncost) {
       colsol[j] = BIG;        // row already assigned, column not assigned.
   }
 
+  // KARP-SIPSER matching of the cheapest entries of each row instead.
+  if (options.initialization == INIT_KARP_SIPSER) {
+    karp_sipser(assigncost, v, rowsol, colsol);
+    for (i = 0; i < dim; i++)
+      matches[i] = rowsol[i] < dim;
+  }
+
   // REDUCTION TRANSFER  
-  for (auto row_it = assigncost.rows().cbegin(); row_it != assigncost.rows().cend(); row_it++) { 
-    i = row_it - assigncost.rows().cbegin();
+  std::vector<int> reduced;   // reduced costs of the scanned row.
+  for (i = 0; i < dim; i++) { 
+    const auto& row = assigncost.row(i);
 
     if (matches[i] == 0)     // fill list of unassigned 'free' rows.
       free[numfree++] = i;
@@ -315,17 +933,25 @@ solution lap(const daestruct::sigma_matrix& assigncost) {
       if (matches[i] == 1)   // transfer reduction from rows that are assigned once.
       {
         j1 = rowsol[i]; 
-        min = BIG;
-        for (auto col_it = (*row_it).begin(); col_it != (*row_it).end(); col_it++) {  
-	  j = col_it.index();
-          if (j != j1)
-	    if (*col_it < (int) min + v[j])
-	      min = *col_it - v[j];
-	}
-        v[j1] = v[j1] - min;
+        // minimum reduced cost over the other columns.
+        const int* h = reduce_row(reduced, row, v);
+        const daestruct::kernels::two_smallest_t mins = daestruct::kernels::two_smallest(h, row.nnz());
+        bool bounded = true;
+        if (daestruct::kernels::column_of(daestruct::kernels::entries(row)[mins.first]) != j1)
+          min = h[mins.first];
+        else if (mins.has_second)
+          min = h[mins.second];
+        else
+          bounded = false;
+        // a row without other columns has nothing to transfer.
+        // the reduced cost of j1 is the row minimum (0 after the column reduction).
+        if (bounded)
+          v[j1] = v[j1] - (min - h[mins.first]);
       }
   }
 
+  const size_t initialized = dim - numfree;
+
   // AUGMENTING ROW REDUCTION 
   int loopcnt = 0;           // do-loop to be done twice.
   do
@@ -337,38 +963,45 @@ solution lap(const daestruct::sigma_matrix& assigncost) {
     k = 0; 
     prvnumfree = numfree; 
     numfree = 0;             // start list of rows still free after augmenting row reduction.
+    size_t chain = 0, chain_k = BIG; // rows scanned in place of free[chain_k].
     while (k < prvnumfree)
     {
       i = free[k]; 
-      auto row_it = assigncost.rows().cbegin() + i;
+      const auto& row = assigncost.row(i);
+      if (k != chain_k) {
+        chain_k = k;
+        chain = 0;
+      }
       k++;
 
+      // an empty row can never be assigned.
+      if (row.begin() == row.end())
+        continue;
+
       // find minimum and second minimum reduced cost over columns.
-      auto col_it = (*row_it).begin();
-      j1 = col_it.index();
-      umin =  *col_it - v[j1]; 
-      usubmin = BIG;
-      for (col_it++; col_it != (*row_it).end(); col_it++) 
-      {
-	j = col_it.index();
-        h = *col_it - v[j];
-        if (h < usubmin) {
-          if (h >= umin) 
-          { 
-            usubmin = h; 
-            j2 = j;
-          }
-          else 
-          { 
-            usubmin = umin; 
-            umin = h; 
-            j2 = j1; 
-            j1 = j;
-          }
-	}
+      const int* reduced_row = reduce_row(reduced, row, v);
+      const daestruct::kernels::two_smallest_t mins = daestruct::kernels::two_smallest(reduced_row, row.nnz());
+      const auto* entries = daestruct::kernels::entries(row);
+      j1 = daestruct::kernels::column_of(entries[mins.first]);
+      umin = reduced_row[mins.first];
+      const bool has_sub = mins.has_second;
+      if (has_sub) {
+        j2 = daestruct::kernels::column_of(entries[mins.second]);
+        usubmin = reduced_row[mins.second];
       }
 
       i0 = colsol[j1];
+      if (!has_sub)
+      {
+        // a single column, there is no subminimum to raise the reduction to.
+        // assign i and leave a de-assigned i0 to the next phase.
+        rowsol[i] = j1; 
+        colsol[j1] = i;
+        if (i0 < colsol.size())
+          free[numfree++] = i0;
+        continue;
+      }
+
       if (umin < usubmin) 
         // change the reduction of the minimum column to increase the minimum
         // reduced cost in the row to the subminimum.
@@ -386,12 +1019,13 @@ solution lap(const daestruct::sigma_matrix& assigncost) {
       colsol[j1] = i;
 
       if (i0 < colsol.size())           // minimum column j1 assigned earlier.
-      {  if (umin < usubmin) 
+      {  if (umin < usubmin && ++chain < dim) 
           // put in current k, and go back to that k.
           // continue augmenting path i - j1 with i0.
           free[--k] = i0; 
         else 
-          // no further augmenting reduction possible.
+          // no further augmenting reduction possible (or the path cycles: a
+          // structurally singular matrix lowers the reductions without bound).
           // store i0 in list of free rows for next phase.
           free[numfree++] = i0; 
       }
@@ -402,16 +1036,60 @@ solution lap(const daestruct::sigma_matrix& assigncost) {
   t.report();
   std::cout << "Done LAP initialization. " << numfree << " unassigned rows remaining." << std::endl;
   
-  // AUGMENT SOLUTION for each free row.
+  const size_t row_reduced = std::count_if(colsol.begin(), colsol.end(), [dim](daestruct::index_t i) { return i < dim; }) - initialized;
+
+  // AUGMENT SOLUTION for each free row, the rest in phases once that gets expensive.
+  const augmentation_mode mode = options.augmentation;
   augmentation_data data(assigncost.dimension());
-  for (f = 0; f < numfree; f++) {
-    augment(data, assigncost, v, free[f], rowsol, colsol);
+  size_t scanned_columns = 0;
+  size_t repeated = 0;
+  f = 0;
+  if (mode == AUGMENT_PARALLEL && !options.cancelled()) {
+    unsigned threads = options.threads;
+    if (threads == 0)
+      threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = std::max<size_t>(1, std::min<size_t>(threads, numfree));
+    repeated = augment_speculatively(data, assigncost, v, free, numfree, rowsol, colsol, scanned_columns, threads);
+    f = numfree;
+  }
+
+  size_t recent_columns = 0; // moving sum of the last search_window searches.
+  for (; f < numfree && mode != AUGMENT_PHASES; f++) {
+    // the searches got expensive, the rest is cheaper in phases.
+    if (mode == AUGMENT_ADAPTIVE && recent_columns * (numfree - f) > phase_work * search_window * dim)
+      break;
+    // cancelled: the phases below leave the remaining rows unassigned.
+    if (options.cancelled())
+      break;
+
+    // a row de-assigned above may still point to its old column.
+    if (!augment(data, assigncost, v, free[f], rowsol, colsol))
+      rowsol[free[f]] = BIG;
+    scanned_columns += data.ready.size();
+    recent_columns = recent_columns - recent_columns / search_window + data.ready.size();
+  }
+
+  // AUGMENT the remaining free rows in phases.
+  size_t searches = f + repeated;
+  std::vector<size_t> phase_free(free + f, free + numfree);
+  for (const size_t r : phase_free)
+    rowsol[r] = BIG;
+  while (!phase_free.empty() && !options.cancelled() && augment_phase(data, assigncost, u, v, phase_free, rowsol, colsol)) {
+    scanned_columns += data.ready.size();
+    searches++;
   }
 
   // calculate optimal cost.
   int lapcost = 0;
+  size_t unassigned = 0;
   for (unsigned int i = 0; i < rowsol.size(); i++) {
     j = rowsol[i];
+    if (j >= dim) {
+      // structurally singular, no augmenting path for this row.
+      u[i] = 0;
+      unassigned++;
+      continue;
+    }
     u[i] = assigncost(i,j) - v[j];
     lapcost = lapcost + assigncost(i,j); 
   }
@@ -433,11 +1111,21 @@ solution lap(const daestruct::sigma_matrix& assigncost) {
   sol.rowsol = std::move(rowsol);
   sol.colsol = std::move(colsol);
   sol.cost = lapcost;
+  sol.unassigned = unassigned;
+  sol.augmentations = searches;
+  sol.repeated_searches = repeated;
+  sol.initialized_rows = initialized;
+  sol.row_reduced_rows = row_reduced;
+  sol.augmented_rows = dim - unassigned - initialized - row_reduced;
+  sol.scanned_columns = scanned_columns;
 
   return sol;
 }
 
+solution lap(const daestruct::sigma_matrix& assigncost, const lap_options& options) {
+  return lap_impl(assigncost, options);
+}
 
-
-
-
+solution lap(const daestruct::mapped_sigma_matrix& assigncost, const lap_options& options) {
+  return lap_impl(assigncost, options);
+}
@@ -0,0 +1,316 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  Cost-scaling assignment, after
+
+  "An Efficient Cost Scaling Algorithm for the Assignment Problem,"
+  Mathematical Programming 71, 153-177, 1995
+
+  by A. V. Goldberg and R. Kennedy.
+
+  The refine step is the double push of the paper (a bid of a row with an 
+  excess for its cheapest column, which pushes the previous owner out), 
+  relabeling the column to the second cheapest reduced cost plus epsilon.
+*/
+
+#include <algorithm>
+#include <climits>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+
+#include "lap.hpp"
+#include "row_kernels.hpp"
+#include <daestruct/mapped_sigma_matrix.hpp>
+
+using daestruct::index_t;
+using daestruct::kernels::column_of;
+using daestruct::kernels::cost_of;
+using daestruct::kernels::entries;
+
+typedef long long price_t;
+
+/* epsilon shrinks by this factor per refine */
+static const price_t scaling_factor = 8;
+
+/**
+ * A maximum cardinality matching (Hopcroft-Karp) in rowsol/colsol, returns its size
+ */
+template<class Matrix>
+static size_t maximum_matching(const Matrix& cost, std::vector<index_t>& rowsol, std::vector<index_t>& colsol) {
+  const size_t dim = cost.dimension();
+  const size_t unreached = SIZE_MAX;
+
+  /* greedy start */
+  size_t matched = 0;
+  for (size_t i = 0; i < dim; i++) {
+    const auto& row = cost.row(i);
+    const auto* e = entries(row);
+    for (size_t k = 0; k < row.nnz(); k++)
+      if (colsol[column_of(e[k])] >= dim) {
+	rowsol[i] = column_of(e[k]);
+	colsol[column_of(e[k])] = i;
+	matched++;
+	break;
+      }
+  }
+
+  std::vector<size_t> layer(dim), next(dim);
+  std::vector<index_t> queue, stack;
+  while (matched < dim) {
+    /* layers of the alternating paths from the free rows */
+    queue.clear();
+    for (size_t i = 0; i < dim; i++) {
+      layer[i] = rowsol[i] >= dim ? 0 : unreached;
+      if (rowsol[i] >= dim)
+	queue.push_back(i);
+    }
+
+    bool found = false;
+    for (size_t q = 0; q < queue.size(); q++) {
+      const index_t i = queue[q];
+      const auto& row = cost.row(i);
+      const auto* e = entries(row);
+      for (size_t k = 0; k < row.nnz(); k++) {
+	const index_t i2 = colsol[column_of(e[k])];
+	if (i2 >= dim)
+	  found = true;
+	else if (layer[i2] == unreached) {
+	  layer[i2] = layer[i] + 1;
+	  queue.push_back(i2);
+	}
+      }
+    }
+    if (!found)
+      break;
+
+    /* augment along (mostly) shortest paths, depth-first without recursion */
+    std::fill(next.begin(), next.end(), 0);
+    size_t augmented = 0;
+    for (size_t f = 0; f < dim; f++) {
+      if (rowsol[f] < dim || layer[f] != 0)
+	continue;
+
+      stack.assign(1, f);
+      while (!stack.empty()) {
+	const index_t i = stack.back();
+	const auto& row = cost.row(i);
+	if (next[i] == row.nnz()) {
+	  layer[i] = unreached;
+	  stack.pop_back();
+	  continue;
+	}
+
+	const index_t j = column_of(entries(row)[next[i]++]);
+	const index_t i2 = colsol[j];
+	if (i2 >= dim) {
+	  /* every row on the stack takes the column it left through */
+	  for (const index_t r : stack) {
+	    const index_t c = column_of(entries(cost.row(r))[next[r] - 1]);
+	    rowsol[r] = c;
+	    colsol[c] = r;
+	  }
+	  augmented++;
+	  break;
+	}
+	if (layer[i2] == layer[i] + 1)
+	  stack.push_back(i2);
+      }
+    }
+
+    if (augmented == 0)
+      break;
+    matched += augmented;
+  }
+
+  return matched;
+}
+
+/* rounding towards negative infinity */
+static price_t floor_div(price_t a, price_t b) {
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+/* the solution of a cancelled cost scaling, no row is assigned */
+static solution cancelled_solution(size_t dim, size_t bids, size_t scanned) {
+  solution sol;
+  sol.u.resize(dim);
+  sol.v.resize(dim);
+  sol.rowsol.assign(dim, BIG);
+  sol.colsol.assign(dim, BIG);
+  sol.cost = 0;
+  sol.unassigned = dim;
+  sol.augmentations = bids;
+  sol.scanned_columns = scanned;
+  return sol;
+}
+
+template<class Matrix>
+static solution lap_cost_scaling_impl(const Matrix& assigncost, const lap_options& options) {
+  const size_t dim = assigncost.dimension();
+  std::vector<index_t> rowsol(dim, BIG), colsol(dim, BIG);
+
+  /* the bids would never end, so let the LAP find a maximal assignment */
+  if (maximum_matching(assigncost, rowsol, colsol) < dim)
+    return lap(assigncost, options);
+
+  /* 
+   * With costs scaled by dim + 1, an epsilon-optimal assignment for epsilon = 1 
+   * is optimal for the integer costs
+   */
+  const price_t scale = price_t(dim) + 1;
+  price_t largest = 0;
+  for (size_t i = 0; i < dim; i++) {
+    const auto& row = assigncost.row(i);
+    const auto* e = entries(row);
+    for (size_t k = 0; k < row.nnz(); k++)
+      largest = std::max(largest, std::abs(price_t(cost_of(e[k]))) * scale);
+  }
+
+  std::vector<price_t> price(dim);
+  std::vector<index_t> excess;
+  size_t bids = 0, scanned = 0;
+  price_t epsilon = std::max<price_t>(1, largest / scaling_factor);
+  for (;;) {
+    if (options.cancelled())
+      return cancelled_solution(dim, bids, scanned);
+
+    /* refine: every row starts with an excess */
+    std::fill(rowsol.begin(), rowsol.end(), BIG);
+    std::fill(colsol.begin(), colsol.end(), BIG);
+    excess.resize(dim);
+    for (size_t i = 0; i < dim; i++)
+      excess[i] = dim - 1 - i;
+
+    while (!excess.empty()) {
+      const index_t i = excess.back();
+      excess.pop_back();
+
+      const auto& row = assigncost.row(i);
+      const auto* e = entries(row);
+      price_t first = LLONG_MAX, second = LLONG_MAX;
+      index_t j1 = 0;
+      for (size_t k = 0; k < row.nnz(); k++) {
+	const price_t reduced = scale * cost_of(e[k]) + price[column_of(e[k])];
+	if (reduced < first) {
+	  second = first;
+	  first = reduced;
+	  j1 = column_of(e[k]);
+	} else if (reduced < second)
+	  second = reduced;
+      }
+      /* a single column: nothing to compare with, the row takes it anyway */
+      if (second == LLONG_MAX)
+	second = first;
+
+      /* double push: i takes j1, relabeled to stay epsilon-optimal, its owner gets the excess */
+      price[j1] += second - first + epsilon;
+      const index_t owner = colsol[j1];
+      if (owner < dim) {
+	rowsol[owner] = BIG;
+	excess.push_back(owner);
+      }
+      rowsol[i] = j1;
+      colsol[j1] = i;
+      bids++;
+      scanned += row.nnz();
+    }
+
+    if (epsilon == 1)
+      break;
+    epsilon = std::max<price_t>(1, epsilon / scaling_factor);
+  }
+
+  /*
+   * Exact duals: v[j] is the shortest path to j in the graph of the columns with an edge 
+   * rowsol[i] -> k of length cost(i,k) - cost(i,rowsol[i]) for every entry (i,k), 
+   * and an edge of length 0 from a source to every column. With the potential -price
+   * and one added to every edge, all lengths (in scaled costs) are non-negative, and
+   * the shortest of these paths have the smallest unscaled length (a path has less
+   * than scale edges).
+   */
+  price_t source = LLONG_MAX;
+  for (size_t j = 0; j < dim; j++)
+    source = std::min(source, price[j]);
+  source = -source;
+
+  typedef std::pair<price_t, index_t> queued;
+  std::vector<price_t> dist(dim);
+  std::vector<queued> initial(dim);
+  for (size_t j = 0; j < dim; j++) {
+    dist[j] = source + price[j] + 1;
+    initial[j] = queued(dist[j], j);
+  }
+  std::priority_queue<queued, std::vector<queued>, std::greater<queued>> queue(std::greater<queued>(), std::move(initial));
+  std::vector<char> settled(dim);
+  std::vector<int> u(dim), v(dim);
+  int lapcost = 0;
+  while (!queue.empty()) {
+    const queued top = queue.top();
+    queue.pop();
+    const index_t j = top.second;
+    if (settled[j] || top.first != dist[j])
+      continue;
+    settled[j] = true;
+
+    const index_t i = colsol[j];
+    const auto& row = assigncost.row(i);
+    const auto* e = entries(row);
+    const price_t assigned = *assigncost.find_element(i, j);
+    for (size_t k = 0; k < row.nnz(); k++) {
+      const index_t j2 = column_of(e[k]);
+      const price_t length = scale * (cost_of(e[k]) - assigned) - price[j] + price[j2] + 1;
+      if (length < 0)
+	throw std::logic_error("cost scaling: the assignment is not 1-optimal");
+      if (!settled[j2] && dist[j] + length < dist[j2]) {
+	dist[j2] = dist[j] + length;
+	queue.push(queued(dist[j2], j2));
+      }
+    }
+  }
+
+  for (size_t j = 0; j < dim; j++)
+    v[j] = floor_div(dist[j] - source - price[j] - 1, scale);
+  for (size_t i = 0; i < dim; i++) {
+    const int cost = assigncost(i, rowsol[i]);
+    u[i] = cost - v[rowsol[i]];
+    lapcost += cost;
+  }
+
+  solution sol;
+  sol.u = std::move(u);
+  sol.v = std::move(v);
+  sol.rowsol = std::move(rowsol);
+  sol.colsol = std::move(colsol);
+  sol.cost = lapcost;
+  sol.unassigned = 0;
+  sol.augmentations = bids;
+  sol.scanned_columns = scanned;
+  return sol;
+}
+
+solution lap_cost_scaling(const daestruct::sigma_matrix& assigncost, const lap_options& options) {
+  return lap_cost_scaling_impl(assigncost, options);
+}
+
+solution lap_cost_scaling(const daestruct::mapped_sigma_matrix& assigncost, const lap_options& options) {
+  return lap_cost_scaling_impl(assigncost, options);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <daestruct/mapped_sigma_matrix.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace daestruct {
+
+  static const char magic[8] = { 'D', 'A', 'E', 'S', 'I', 'G', 'M', 'A' };
+
+  const der_t* mapped_sigma_matrix::row_t::find_element(size_t j) const {
+    const entry* e = std::lower_bound(first, last, j, 
+				      [](const entry& a, size_t col) { return a.column < col; });
+    if (e != last && e->column == j)
+      return &e->cost;
+    else
+      return nullptr;
+  }
+
+  bool mapped_sigma_matrix::is_mapped_file(const char* data, size_t size) {
+    return size >= sizeof(magic) && std::memcmp(data, magic, sizeof(magic)) == 0;
+  }
+
+  size_t mapped_sigma_matrix::entries_offset(size_t dimension) {
+    const size_t end = sizeof(header) + (dimension + 1) * sizeof(uint64_t) + dimension * sizeof(index_t);
+    const size_t align = alignof(entry);
+    return (end + align - 1) / align * align;
+  }
+
+  mapped_sigma_matrix::writer::writer(const std::string& path, size_t dim) 
+    : file(std::fopen(path.c_str(), "wb")), dimension(dim), row_start(dim + 1), 
+      minimum_row(dim), minimum(dim), seen(dim) {
+    if (!file)
+      throw std::runtime_error("mapped_sigma_matrix: cannot create " + path);
+
+    /* the entries come last, their number is not known yet */
+    if (std::fseek(file, entries_offset(dimension), SEEK_SET) != 0)
+      throw std::runtime_error("mapped_sigma_matrix: cannot write " + path);
+  }
+
+  mapped_sigma_matrix::writer::~writer() {
+    /* an unfinished file has no header, so it is never mapped by accident */
+    if (file)
+      std::fclose(file);
+  }
+
+  void mapped_sigma_matrix::writer::push_back(size_t i, size_t j, der_t x) {
+    if (i < current_row || i >= dimension || j >= dimension)
+      throw std::runtime_error("mapped_sigma_matrix: entries need to be written in row-major order");
+
+    if (i > current_row)
+      next_column = 0;
+    /* the rows are binary searched, see row_t::find_element */
+    if (j < next_column)
+      throw std::runtime_error("mapped_sigma_matrix: columns need to be written in increasing order, once per row");
+
+    while (current_row < i)
+      row_start[++current_row] = nonzeros;
+
+    if (!seen[j] || minimum[j] > x) {
+      minimum_row[j] = i;
+      minimum[j] = x;
+      seen[j] = true;
+    }
+
+    entry e;
+    std::memset(&e, 0, sizeof(e));
+    e.column = j;
+    e.cost = x;
+    if (std::fwrite(&e, sizeof(e), 1, file) != 1)
+      throw std::runtime_error("mapped_sigma_matrix: cannot write an entry");
+
+    nonzeros++;
+    next_column = j + 1;
+    fingerprint += sigma_matrix::entry_hash(i, j, x);
+  }
+
+  void mapped_sigma_matrix::writer::close() {
+    while (current_row < dimension)
+      row_start[++current_row] = nonzeros;
+
+    header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+    h.index_size = sizeof(index_t);
+    h.der_size = sizeof(der_t);
+    h.dimension = dimension;
+    h.nonzeros = nonzeros;
+    h.fingerprint = fingerprint;
+
+    const bool written = std::fseek(file, 0, SEEK_SET) == 0 
+      && std::fwrite(&h, sizeof(h), 1, file) == 1
+      && std::fwrite(row_start.data(), sizeof(uint64_t), row_start.size(), file) == row_start.size()
+      && std::fwrite(minimum_row.data(), sizeof(index_t), minimum_row.size(), file) == minimum_row.size();
+
+    const bool closed = std::fclose(file) == 0;
+    file = nullptr;
+    if (!written || !closed)
+      throw std::runtime_error("mapped_sigma_matrix: cannot write the row index");
+  }
+
+  void mapped_sigma_matrix::write(const sigma_matrix& sigma, const std::string& path) {
+    writer w(path, sigma.dimension());
+    for (size_t i = 0; i < sigma.dimension(); i++) {
+      const sigma_matrix::row_t& row = sigma.row(i);
+      for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++)
+	w.push_back(i, col_iter.index(), *col_iter);
+    }
+    w.close();
+  }
+
+  mapped_sigma_matrix::mapped_sigma_matrix(const std::string& path) 
+    : file(path.c_str(), boost::interprocess::read_only), 
+      region(file, boost::interprocess::read_only) {
+    const char* base = static_cast<const char*>(region.get_address());
+    const size_t size = region.get_size();
+
+    head = reinterpret_cast<const header*>(base);
+    if (size < sizeof(header) || std::memcmp(head->magic, magic, sizeof(magic)) != 0)
+      throw std::runtime_error("mapped_sigma_matrix: " + path + " is no sigma matrix");
+
+    if (head->version != version || head->index_size != sizeof(index_t) || head->der_size != sizeof(der_t))
+      throw std::runtime_error("mapped_sigma_matrix: " + path + " was written by an incompatible build");
+
+    const size_t offset = entries_offset(head->dimension);
+    if (size < offset + head->nonzeros * sizeof(entry))
+      throw std::runtime_error("mapped_sigma_matrix: " + path + " is truncated");
+
+    row_start = reinterpret_cast<const uint64_t*>(base + sizeof(header));
+    minimum_row = reinterpret_cast<const index_t*>(row_start + head->dimension + 1);
+    entries = reinterpret_cast<const entry*>(base + offset);
+  }
+
+  void mapped_sigma_matrix::advise(access pattern) const {
+    using boost::interprocess::mapped_region;
+    switch (pattern) {
+    case ACCESS_NORMAL:
+      region.advise(mapped_region::advice_normal);
+      break;
+    case ACCESS_SEQUENTIAL:
+      region.advise(mapped_region::advice_sequential);
+      break;
+    case ACCESS_RANDOM:
+      region.advise(mapped_region::advice_random);
+      break;
+    case ACCESS_WILLNEED:
+      region.advise(mapped_region::advice_willneed);
+      break;
+    }
+  }
+}
@@ -0,0 +1,292 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <daestruct/matrix_market.hpp>
+#include <daestruct/mapped_sigma_matrix.hpp>
+#include <daestruct/streaming_builder.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <queue>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include <boost/interprocess/file_mapping.hpp>
+#include <boost/interprocess/mapped_region.hpp>
+
+namespace daestruct {
+  namespace analysis {
+
+    typedef streaming_builder::entry entry;
+
+    /* every parser thread gets at least this many bytes */
+    static const size_t min_bytes_per_thread = 1 << 20;
+
+    static void fail(const std::string& msg) {
+      throw std::runtime_error("matrix market: " + msg);
+    }
+
+    static bool is_blank(char c) {
+      return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    static const char* skip_blanks(const char* p, const char* end) {
+      while (p < end && is_blank(*p))
+	p++;
+      return p;
+    }
+
+    static const char* line_end(const char* p, const char* end) {
+      const char* e = static_cast<const char*>(std::memchr(p, '\n', end - p));
+      return e ? e : end;
+    }
+
+    static const char* next_line(const char* e, const char* end) {
+      return e < end ? e + 1 : end;
+    }
+
+    /* parse a decimal integer at p, moving p behind it */
+    static bool parse_long(const char*& p, const char* end, long& value) {
+      p = skip_blanks(p, end);
+      bool negative = false;
+      if (p < end && (*p == '-' || *p == '+'))
+	negative = *p++ == '-';
+
+      const char* digits = p;
+      long v = 0;
+      while (p < end && *p >= '0' && *p <= '9')
+	v = 10 * v + (*p++ - '0');
+
+      if (p == digits || p - digits > 18)
+	return false;
+      value = negative ? -v : v;
+      return true;
+    }
+
+    struct header {
+      size_t rows = 0, cols = 0, nonzeros = 0;
+      bool pattern = false;
+      const char* body = nullptr;
+    };
+
+    static header parse_header(const char* begin, const char* end) {
+      header h;
+      const char* e = line_end(begin, end);
+
+      std::istringstream banner(std::string(begin, e));
+      std::vector<std::string> words;
+      std::string word;
+      while (banner >> word) {
+	std::transform(word.begin(), word.end(), word.begin(), ::tolower);
+	words.push_back(word);
+      }
+      if (words.size() != 5 || words[0] != "%%matrixmarket" || words[1] != "matrix")
+	fail("missing %%MatrixMarket banner");
+      if (words[2] != "coordinate" || (words[3] != "integer" && words[3] != "pattern") || words[4] != "general")
+	fail("only 'coordinate integer general' and 'coordinate pattern general' are supported");
+      h.pattern = words[3] == "pattern";
+
+      /* skip comments up to the size line */
+      for (const char* p = next_line(e, end); p < end; p = next_line(e, end)) {
+	e = line_end(p, end);
+	const char* q = skip_blanks(p, e);
+	if (q == e || *q == '%')
+	  continue;
+
+	long rows, cols, nonzeros;
+	if (!parse_long(q, e, rows) || !parse_long(q, e, cols) || !parse_long(q, e, nonzeros) 
+	    || skip_blanks(q, e) != e || rows < 0 || cols < 0 || nonzeros < 0)
+	  fail("malformed size line '" + std::string(p, e) + "'");
+	h.rows = rows;
+	h.cols = cols;
+	h.nonzeros = nonzeros;
+	h.body = next_line(e, end);
+	return h;
+      }
+      fail("missing size line");
+      return h;
+    }
+
+    /* parse all entries in [p, end) and sort them */
+    static void parse_entries(const char* p, const char* end, const header& h, std::vector<entry>& out) {
+      while (p < end) {
+	const char* e = line_end(p, end);
+	const char* q = skip_blanks(p, e);
+	if (q == e || *q == '%') {
+	  p = next_line(e, end);
+	  continue;
+	}
+
+	long i, j, der = 0;
+	if (!parse_long(q, e, i) || !parse_long(q, e, j) || (!h.pattern && !parse_long(q, e, der)) 
+	    || skip_blanks(q, e) != e)
+	  fail("malformed entry '" + std::string(p, e) + "'");
+	if (i < 1 || j < 1 || size_t(i) > h.rows || size_t(j) > h.cols)
+	  fail("entry '" + std::string(p, e) + "' out of range");
+
+	out.push_back(entry { index_t(i - 1), index_t(j - 1), der_t(-der) });
+	p = next_line(e, end);
+      }
+      std::sort(out.begin(), out.end(), streaming_builder::entry_less);
+    }
+
+    InputProblem parse_matrix_market(const char* begin, const char* end, unsigned threads) {
+      const header h = parse_header(begin, end);
+      if (h.rows != h.cols)
+	fail("the incidence matrix needs to be square");
+
+      const size_t length = end - h.body;
+      if (threads == 0) {
+	threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::max<size_t>(1, std::min<size_t>(threads, length / min_bytes_per_thread));
+      }
+
+      /* split the body at line breaks */
+      std::vector<const char*> starts(threads + 1, end);
+      starts[0] = h.body;
+      for (unsigned k = 1; k < threads; k++) {
+	const char* p = std::max(h.body + length / threads * k, starts[k - 1]);
+	if (p > h.body && p[-1] != '\n')
+	  p = next_line(line_end(p, end), end);
+	starts[k] = p;
+      }
+
+      std::vector<std::vector<entry>> parts(threads);
+      std::vector<std::exception_ptr> errors(threads);
+      auto parse = [&](unsigned k) {
+	try {
+	  parse_entries(starts[k], starts[k + 1], h, parts[k]);
+	} catch (...) {
+	  errors[k] = std::current_exception();
+	}
+      };
+
+      std::vector<std::thread> workers;
+      for (unsigned k = 1; k < threads; k++)
+	workers.emplace_back(parse, k);
+      parse(0);
+      for (std::thread& w : workers)
+	w.join();
+
+      size_t found = 0;
+      for (unsigned k = 0; k < threads; k++) {
+	if (errors[k])
+	  std::rethrow_exception(errors[k]);
+	found += parts[k].size();
+      }
+      if (found != h.nonzeros) {
+	std::ostringstream msg;
+	msg << "expected " << h.nonzeros << " entries, found " << found;
+	fail(msg.str());
+      }
+
+      /* merge the sorted parts, dropping duplicates */
+      InputProblem problem(h.rows);
+      std::vector<size_t> pos(threads);
+      auto greater = [&](unsigned a, unsigned b) { return streaming_builder::entry_less(parts[b][pos[b]], parts[a][pos[a]]); };
+      std::priority_queue<unsigned, std::vector<unsigned>, decltype(greater)> heads(greater);
+      for (unsigned k = 0; k < threads; k++)
+	if (!parts[k].empty())
+	  heads.push(k);
+
+      const entry* last = nullptr;
+      while (!heads.empty()) {
+	const unsigned k = heads.top();
+	heads.pop();
+	const entry& e = parts[k][pos[k]++];
+	if (pos[k] < parts[k].size())
+	  heads.push(k);
+
+	if (!last || !streaming_builder::same_position(e, *last))
+	  problem.sigma.push_back(e.row, e.col, e.der);
+	last = &e;
+      }
+
+      return problem;
+    }
+
+    InputProblem read_problem(const std::string& path, unsigned threads) {
+      using namespace boost::interprocess;
+      file_mapping file;
+      mapped_region region;
+      try {
+	file = file_mapping(path.c_str(), read_only);
+	region = mapped_region(file, read_only);
+      } catch (const interprocess_exception&) {
+	fail("cannot read " + path);
+      }
+
+      const char* data = static_cast<const char*>(region.get_address());
+      const size_t size = region.get_size();
+
+      if (mapped_sigma_matrix::is_mapped_file(data, size)) {
+	const mapped_sigma_matrix sigma(path);
+	InputProblem problem(sigma.dimension());
+	for (size_t i = 0; i < sigma.dimension(); i++) {
+	  const mapped_sigma_matrix::row_t row = sigma.row(i);
+	  for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++)
+	    problem.sigma.push_back(i, col_iter.index(), *col_iter);
+	}
+	return problem;
+      }
+
+      region.advise(mapped_region::advice_sequential);
+      return parse_matrix_market(data, data + size, threads);
+    }
+
+    void write_matrix_market(const sigma_matrix& sigma, std::ostream& out) {
+      size_t nonzeros = 0;
+      for (size_t i = 0; i < sigma.dimension(); i++)
+	nonzeros += sigma.row(i).nnz();
+
+      out << "%%MatrixMarket matrix coordinate integer general\n"
+	  << "% daestruct structure: rows are equations, columns are variables, values are the highest derivatives\n"
+	  << sigma.dimension() << ' ' << sigma.dimension() << ' ' << nonzeros << '\n';
+
+      for (size_t i = 0; i < sigma.dimension(); i++) {
+	const sigma_matrix::row_t& row = sigma.row(i);
+	for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++)
+	  out << i + 1 << ' ' << col_iter.index() + 1 << ' ' << -*col_iter << '\n';
+      }
+    }
+
+    void write_matrix_market(const AnalysisResult& result, std::ostream& out) {
+      const size_t n = result.c.size();
+
+      out << "%%MatrixMarket matrix array integer general\n"
+	  << "% daestruct analysis result, status " << result.status << "\n"
+	  << "% columns: c (equation offsets), d (variable offsets), "
+	  << "variable assigned to the equation (1-based, 0 if unassigned)\n"
+	  << n << " 3\n";
+
+      /* arrays are written column by column */
+      for (size_t i = 0; i < n; i++)
+	out << result.c[i] << '\n';
+      for (size_t j = 0; j < n; j++)
+	out << result.d[j] << '\n';
+      for (size_t i = 0; i < n; i++) {
+	const size_t j = i < result.row_assignment.size() ? result.row_assignment[i] : n;
+	out << (j < n ? j + 1 : 0) << '\n';
+      }
+    }
+  }
+}
@@ -0,0 +1,181 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <daestruct/reduced_system.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace daestruct {
+  namespace analysis {
+
+    /* the strongly connected components (Tarjan) of the equations, dependencies first */
+    static void block_triangular_form(const sigma_matrix& sigma, const AnalysisResult& result, ReducedSystem& r) {
+      const size_t n = sigma.dimension();
+      const std::vector<index_t>& rowsol = result.row_assignment;
+      const std::vector<index_t>& colsol = result.col_assignment;
+
+      /* the entries of the highest-derivative Jacobian are those where d_j - c_i = sigma_ij */
+      auto tight = [&result](size_t i, size_t j, der_t cost) { return result.d[j] - result.c[i] == -cost; };
+
+      /* equation i depends on equation i' if it contains the variable assigned to i' */
+      struct frame {
+	index_t equation;
+	sigma_matrix::row_t::const_iterator next;
+      };
+
+      const index_t unvisited = n;
+      std::vector<index_t> index(n, unvisited), lowlink(n);
+      std::vector<bool> on_stack(n);
+      std::vector<index_t> stack;
+      std::vector<frame> calls;
+      index_t counter = 0;
+
+      auto visit = [&](index_t i) {
+	index[i] = lowlink[i] = counter++;
+	stack.push_back(i);
+	on_stack[i] = true;
+	calls.push_back(frame { i, sigma.row(i).begin() });
+      };
+
+      r.block_start.assign(1, 0);
+      r.block_equations.reserve(n);
+
+      for (size_t root = 0; root < n; root++) {
+	if (index[root] != unvisited)
+	  continue;
+
+	/* iterative Tarjan, a recursion would overflow the stack on long chains */
+	visit(root);
+	while (!calls.empty()) {
+	  const index_t i = calls.back().equation;
+	  const sigma_matrix::row_t& row = sigma.row(i);
+
+	  bool descended = false;
+	  for (auto& it = calls.back().next; it != row.end(); ++it) {
+	    const size_t j = it.index();
+	    if (j == rowsol[i] || !tight(i, j, *it))
+	      continue;
+
+	    const index_t w = colsol[j];
+	    if (index[w] == unvisited) {
+	      ++it;
+	      visit(w);
+	      descended = true;
+	      break;
+	    } else if (on_stack[w]) {
+	      lowlink[i] = std::min(lowlink[i], index[w]);
+	    }
+	  }
+	  if (descended)
+	    continue;
+
+	  calls.pop_back();
+	  if (!calls.empty()) {
+	    const index_t parent = calls.back().equation;
+	    lowlink[parent] = std::min(lowlink[parent], lowlink[i]);
+	  }
+
+	  /* i is the root of a strongly connected component, i.e. of a block */
+	  if (lowlink[i] == index[i]) {
+	    index_t w;
+	    do {
+	      w = stack.back();
+	      stack.pop_back();
+	      on_stack[w] = false;
+	      r.block_equations.push_back(w);
+	    } while (w != i);
+	    r.block_start.push_back(r.block_equations.size());
+	  }
+	}
+      }
+    }
+
+    /**
+     * Mattsson-Söderlind on the structure: the equations differentiated at least l times 
+     * need as many dummy derivatives of order d_j - l + 1, taken from the columns of level l - 1.
+     * Restricted to those equations, the assignment is a matching into exactly these 
+     * columns on every level, so the assigned variables are valid candidates.
+     */
+    static void dummy_derivatives(const AnalysisResult& result, ReducedSystem& r) {
+      const size_t n = result.c.size();
+      const std::vector<int>& c = result.c;
+      const std::vector<int>& d = result.d;
+
+      const int levels = n ? *std::max_element(c.begin(), c.end()) : 0;
+
+      /* number of equations differentiated at least l times */
+      std::vector<index_t> count(levels + 2);
+      for (size_t i = 0; i < n; i++)
+	count[c[i]]++;
+      for (int l = levels; l > 0; l--)
+	count[l - 1] += count[l];
+
+      r.dummy_start.assign(levels + 1, 0);
+      for (int l = 1; l <= levels; l++)
+	r.dummy_start[l] = r.dummy_start[l - 1] + count[l];
+
+      r.dummy_variables.resize(r.dummy_start.back());
+      r.dummy_orders.resize(r.dummy_start.back());
+      std::vector<index_t> pos(r.dummy_start.begin(), r.dummy_start.end() - 1);
+      for (size_t i = 0; i < n; i++) {
+	const size_t j = result.row_assignment[i];
+	for (int l = 1; l <= c[i]; l++) {
+	  const index_t k = pos[l - 1]++;
+	  r.dummy_variables[k] = j;
+	  r.dummy_orders[k] = d[j] - l + 1;
+	}
+      }
+    }
+
+    ReducedSystem reduce(const sigma_matrix& sigma, const AnalysisResult& result) {
+      const size_t n = sigma.dimension();
+      if (result.status != ANALYSIS_OK)
+	throw std::invalid_argument("reduce: the problem is structurally singular");
+      if (result.c.size() != n || result.d.size() != n || result.row_assignment.size() != n)
+	throw std::invalid_argument("reduce: the result does not belong to the given structure");
+
+      ReducedSystem r;
+      r.equation_start.resize(n + 1);
+      r.variable_start.resize(n + 1);
+      size_t nonzeros = 0;
+      for (size_t i = 0; i < n; i++) {
+	r.equation_start[i + 1] = r.equation_start[i] + result.c[i] + 1;
+	r.variable_start[i + 1] = r.variable_start[i] + result.d[i] + 1;
+	nonzeros += (result.c[i] + 1) * sigma.row(i).nnz();
+      }
+
+      r.row_start.reserve(r.equations() + 1);
+      r.row_start.push_back(0);
+      r.columns.reserve(nonzeros);
+      for (size_t i = 0; i < n; i++) {
+	const sigma_matrix::row_t& row = sigma.row(i);
+	for (int k = 0; k <= result.c[i]; k++) {
+	  for (auto col_iter = row.begin(); col_iter != row.end(); col_iter++)
+	    r.columns.push_back(r.variable_start[col_iter.index()] + k - *col_iter);
+	  r.row_start.push_back(r.columns.size());
+	}
+      }
+
+      block_triangular_form(sigma, result, r);
+      dummy_derivatives(result, r);
+      return r;
+    }
+  }
+}
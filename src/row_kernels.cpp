@@ -0,0 +1,313 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "row_kernels.hpp"
+
+#include <climits>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define DAESTRUCT_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace daestruct {
+  namespace kernels {
+
+    static_assert(sizeof(mapped_entry) == sizeof(sigma_entry) && alignof(mapped_entry) == alignof(sigma_entry)
+		  && offsetof(mapped_entry, column) == offsetof(sigma_entry, first)
+		  && offsetof(mapped_entry, cost) == offsetof(sigma_entry, second),
+		  "rows of sigma_matrix and mapped_sigma_matrix need the same layout");
+
+    /* layout of an entry for the gathers, the same for both entry types */
+    static const int stride = sizeof(mapped_entry);
+    static const int column_offset = offsetof(mapped_entry, column);
+    static const int cost_offset = offsetof(mapped_entry, cost);
+    /* costs narrower than int are gathered as int and sign extended */
+    static const int cost_shift = sizeof(der_t) < sizeof(int) ? 8 * (sizeof(int) - sizeof(der_t)) : 0;
+
+    /* whether the gathers below can read this layout */
+    static const bool gather_layout = sizeof(der_t) <= sizeof(int) && cost_offset + sizeof(int) <= sizeof(mapped_entry)
+      && (sizeof(index_t) == 8 || sizeof(index_t) == 4);
+
+    template<class Entry>
+    static void reduced_costs_scalar(const Entry* row, size_t n, const int* v, int* out) {
+      for (size_t k = 0; k < n; k++)
+	out[k] = cost_of(row[k]) - v[column_of(row[k])];
+    }
+
+    static two_smallest_t two_smallest_scalar(const int* h, size_t n) {
+      two_smallest_t t;
+      t.first = 0;
+      for (size_t k = 1; k < n; k++)
+	if (h[k] < h[t.first])
+	  t.first = k;
+
+      t.has_second = n > 1;
+      t.second = t.first == 0 ? 1 : 0;
+      for (size_t k = t.second + 1; k < n; k++)
+	if (k != t.first && h[k] < h[t.second])
+	  t.second = k;
+      return t;
+    }
+
+#ifdef DAESTRUCT_X86_KERNELS
+
+    template<class Entry>
+    __attribute__((target("avx2")))
+    static void reduced_costs_avx2(const Entry* row, size_t n, const int* v, int* out) {
+      const char* base = reinterpret_cast<const char*>(row);
+      const __m256i offsets = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(stride));
+
+      size_t k = 0;
+      for (; k + 8 <= n; k += 8, base += 8 * stride) {
+	__m256i cost = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base + cost_offset), offsets, 1);
+	if (cost_shift)
+	  cost = _mm256_srai_epi32(_mm256_slli_epi32(cost, cost_shift), cost_shift);
+
+	__m256i vj;
+	if (sizeof(index_t) == 8) {
+	  const long long* columns = reinterpret_cast<const long long*>(base + column_offset);
+	  const __m256i lo = _mm256_i32gather_epi64(columns, _mm256_castsi256_si128(offsets), 1);
+	  const __m256i hi = _mm256_i32gather_epi64(columns, _mm256_extracti128_si256(offsets, 1), 1);
+	  vj = _mm256_set_m128i(_mm256_i64gather_epi32(v, hi, 4), _mm256_i64gather_epi32(v, lo, 4));
+	} else {
+	  const __m256i columns = _mm256_i32gather_epi32(reinterpret_cast<const int*>(base + column_offset), offsets, 1);
+	  vj = _mm256_i32gather_epi32(v, columns, 4);
+	}
+	_mm256_storeu_si256(reinterpret_cast<__m256i*>(out + k), _mm256_sub_epi32(cost, vj));
+      }
+
+      reduced_costs_scalar(row + k, n - k, v, out + k);
+    }
+
+    /* the minimum of h[0 .. n) without position skip */
+    __attribute__((target("avx2")))
+    static int min_avx2(const int* h, size_t n, size_t skip) {
+      const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+      const __m256i big = _mm256_set1_epi32(INT_MAX);
+      __m256i m = big;
+      size_t k = 0;
+      for (; k + 8 <= n; k += 8) {
+	const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + k));
+	const __m256i skipped = _mm256_cmpeq_epi32(lanes, _mm256_set1_epi32(int(skip - k)));
+	m = _mm256_min_epi32(m, _mm256_blendv_epi8(x, big, skipped));
+      }
+      __m128i m4 = _mm_min_epi32(_mm256_castsi256_si128(m), _mm256_extracti128_si256(m, 1));
+      m4 = _mm_min_epi32(m4, _mm_shuffle_epi32(m4, _MM_SHUFFLE(1, 0, 3, 2)));
+      m4 = _mm_min_epi32(m4, _mm_shuffle_epi32(m4, _MM_SHUFFLE(2, 3, 0, 1)));
+      int result = _mm_cvtsi128_si32(m4);
+      for (; k < n; k++)
+	if (k != skip && h[k] < result)
+	  result = h[k];
+      return result;
+    }
+
+    /* the first position of value in h[0 .. n) other than skip */
+    __attribute__((target("avx2")))
+    static size_t find_avx2(const int* h, size_t n, int value, size_t skip) {
+      const __m256i x = _mm256_set1_epi32(value);
+      size_t k = 0;
+      for (; k + 8 <= n; k += 8) {
+	unsigned mask = _mm256_movemask_ps(_mm256_castsi256_ps(
+	  _mm256_cmpeq_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(h + k)), x)));
+	if (skip >= k && skip < k + 8)
+	  mask &= ~(1u << (skip - k));
+	if (mask)
+	  return k + __builtin_ctz(mask);
+      }
+      for (; k < n; k++)
+	if (k != skip && h[k] == value)
+	  return k;
+      return n;
+    }
+
+    __attribute__((target("avx2")))
+    static two_smallest_t two_smallest_avx2(const int* h, size_t n) {
+      if (n < 8)
+	return two_smallest_scalar(h, n);
+
+      two_smallest_t t;
+      t.first = find_avx2(h, n, min_avx2(h, n, n), n);
+      t.second = find_avx2(h, n, min_avx2(h, n, t.first), t.first);
+      t.has_second = true;
+      return t;
+    }
+
+    /* the 256 bit halves of GCC's intrinsics start out from _mm256_undefined_si256() */
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+    template<class Entry>
+    __attribute__((target("avx512f")))
+    static void reduced_costs_avx512(const Entry* row, size_t n, const int* v, int* out) {
+      const char* base = reinterpret_cast<const char*>(row);
+      const __m512i offsets = _mm512_mullo_epi32(_mm512_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15),
+						 _mm512_set1_epi32(stride));
+
+      /* the last (partial) block is masked, short rows need no scalar tail */
+      for (size_t k = 0; k < n; k += 16, base += 16 * stride) {
+	const __mmask16 mask = n - k >= 16 ? 0xFFFF : __mmask16((1u << (n - k)) - 1);
+
+	__m512i cost = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, offsets, base + cost_offset, 1);
+	if (cost_shift)
+	  cost = _mm512_srai_epi32(_mm512_slli_epi32(cost, cost_shift), cost_shift);
+
+	__m512i vj;
+	if (sizeof(index_t) == 8) {
+	  const __m512i lo = _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), __mmask8(mask), 
+							 _mm512_castsi512_si256(offsets), base + column_offset, 1);
+	  const __m512i hi = _mm512_mask_i32gather_epi64(_mm512_setzero_si512(), __mmask8(mask >> 8), 
+							 _mm512_extracti64x4_epi64(offsets, 1), base + column_offset, 1);
+	  const __m256i vlo = _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), __mmask8(mask), lo, v, 4);
+	  const __m256i vhi = _mm512_mask_i64gather_epi32(_mm256_setzero_si256(), __mmask8(mask >> 8), hi, v, 4);
+	  vj = _mm512_inserti64x4(_mm512_castsi256_si512(vlo), vhi, 1);
+	} else {
+	  const __m512i columns = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, offsets, base + column_offset, 1);
+	  vj = _mm512_mask_i32gather_epi32(_mm512_setzero_si512(), mask, columns, v, 4);
+	}
+	_mm512_mask_storeu_epi32(out + k, mask, _mm512_sub_epi32(cost, vj));
+      }
+    }
+
+    __attribute__((target("avx512f")))
+    static int min_avx512(const int* h, size_t n, size_t skip) {
+      __m512i m = _mm512_set1_epi32(INT_MAX);
+      for (size_t k = 0; k < n; k += 16) {
+	__mmask16 mask = n - k >= 16 ? 0xFFFF : __mmask16((1u << (n - k)) - 1);
+	if (skip >= k && skip < k + 16)
+	  mask &= ~(1u << (skip - k));
+	m = _mm512_mask_min_epi32(m, mask, m, _mm512_maskz_loadu_epi32(mask, h + k));
+      }
+      return _mm512_reduce_min_epi32(m);
+    }
+
+    __attribute__((target("avx512f")))
+    static size_t find_avx512(const int* h, size_t n, int value, size_t skip) {
+      const __m512i x = _mm512_set1_epi32(value);
+      for (size_t k = 0; k < n; k += 16) {
+	__mmask16 mask = n - k >= 16 ? 0xFFFF : __mmask16((1u << (n - k)) - 1);
+	if (skip >= k && skip < k + 16)
+	  mask &= ~(1u << (skip - k));
+	const unsigned found = _mm512_mask_cmpeq_epi32_mask(mask, _mm512_maskz_loadu_epi32(mask, h + k), x);
+	if (found)
+	  return k + __builtin_ctz(found);
+      }
+      return n;
+    }
+
+    __attribute__((target("avx512f")))
+    static two_smallest_t two_smallest_avx512(const int* h, size_t n) {
+      if (n < 4)
+	return two_smallest_scalar(h, n);
+
+      two_smallest_t t;
+      t.first = find_avx512(h, n, min_avx512(h, n, n), n);
+      t.second = find_avx512(h, n, min_avx512(h, n, t.first), t.first);
+      t.has_second = true;
+      return t;
+    }
+
+#pragma GCC diagnostic pop
+
+#endif
+
+    struct implementation {
+      isa which;
+      void (*sigma_costs)(const sigma_entry*, size_t, const int*, int*);
+      void (*mapped_costs)(const mapped_entry*, size_t, const int*, int*);
+      two_smallest_t (*two_smallest)(const int*, size_t);
+    };
+
+    static bool supported(isa which) {
+      switch (which) {
+      case ISA_SCALAR:
+	return true;
+#ifdef DAESTRUCT_X86_KERNELS
+      case ISA_AVX2:
+	return gather_layout && __builtin_cpu_supports("avx2");
+      case ISA_AVX512:
+	return gather_layout && __builtin_cpu_supports("avx512f");
+#endif
+      default:
+	return false;
+      }
+    }
+
+    static implementation implementation_of(isa which) {
+      switch (which) {
+#ifdef DAESTRUCT_X86_KERNELS
+      case ISA_AVX2:
+	return implementation { ISA_AVX2, reduced_costs_avx2<sigma_entry>, reduced_costs_avx2<mapped_entry>, two_smallest_avx2 };
+      case ISA_AVX512:
+	return implementation { ISA_AVX512, reduced_costs_avx512<sigma_entry>, reduced_costs_avx512<mapped_entry>, two_smallest_avx512 };
+#endif
+      default:
+	return implementation { ISA_SCALAR, reduced_costs_scalar<sigma_entry>, reduced_costs_scalar<mapped_entry>, two_smallest_scalar };
+      }
+    }
+
+    /* 
+     * AVX2 unless DAESTRUCT_SIMD says otherwise: rows of DAEs are short and the 
+     * masked AVX-512 gathers lose against AVX2 below ~16 entries per row
+     */
+    static implementation default_implementation() {
+      isa best = ISA_AVX2;
+      const char* choice = std::getenv("DAESTRUCT_SIMD");
+      if (choice && std::strcmp(choice, "scalar") == 0)
+	best = ISA_SCALAR;
+      else if (choice && std::strcmp(choice, "avx512") == 0)
+	best = ISA_AVX512;
+
+      while (!supported(best))
+	best = isa(best - 1);
+      return implementation_of(best);
+    }
+
+    static implementation& current() {
+      static implementation impl = default_implementation();
+      return impl;
+    }
+
+    isa active_isa() {
+      return current().which;
+    }
+
+    bool select_isa(isa which) {
+      if (!supported(which))
+	return false;
+      current() = implementation_of(which);
+      return true;
+    }
+
+    void reduced_costs(const sigma_entry* row, size_t n, const int* v, int* out) {
+      current().sigma_costs(row, n, v, out);
+    }
+
+    void reduced_costs(const mapped_entry* row, size_t n, const int* v, int* out) {
+      current().mapped_costs(row, n, v, out);
+    }
+
+    two_smallest_t two_smallest(const int* h, size_t n) {
+      return current().two_smallest(h, n);
+    }
+  }
+}
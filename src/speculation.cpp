@@ -0,0 +1,161 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include <daestruct/speculation.hpp>
+
+namespace daestruct {
+  namespace analysis {
+
+    /**
+     * Everything the workers need, the speculation joins them before it is gone
+     */
+    struct Speculation::state {
+      std::unique_ptr<const InputProblem> orig;
+      std::unique_ptr<const ChangedProblem> changed;
+      const AnalysisResult result;
+
+      enum progress { QUEUED, RUNNING, DONE, COMMITTED };
+
+      struct candidate {
+	StructChange delta;
+	progress status;
+	SpeculativeResult spec;
+	std::exception_ptr error;
+      };
+
+      std::mutex lock;
+      std::condition_variable done;
+      std::condition_variable queued;
+
+      /* a deque keeps the candidates in place while more are added */
+      std::deque<candidate> candidates;
+      std::deque<size_t> queue;
+      std::vector<std::thread> workers;
+      bool discarded = false;
+      /* stops the analyses still running when the speculation is discarded */
+      std::atomic<bool> cancelled{false};
+
+      state(const InputProblem& base, const AnalysisResult& res) : orig(new InputProblem(base)), result(res) {}
+
+      state(const ChangedProblem& base, const AnalysisResult& res) : changed(new ChangedProblem(base)), result(res) {}
+
+      /**
+       * analyse the candidate (not holding the lock), store the outcome (holding it)
+       */
+      void analyse(std::unique_lock<std::mutex>& guard, candidate& c) {
+	c.status = RUNNING;
+	guard.unlock();
+	SpeculativeResult spec;
+	std::exception_ptr error;
+	try {
+	  if (orig)
+	    spec.problem.reset(new ChangedProblem(*orig, result, c.delta));
+	  else
+	    spec.problem.reset(new ChangedProblem(*changed, result, c.delta));
+	  /* a committed problem must not point to the flag once the speculation is gone */
+	  spec.problem->options.cancel = &cancelled;
+	  spec.result = spec.problem->pryceAlgorithmConsuming();
+	  spec.problem->options.cancel = nullptr;
+	} catch (...) {
+	  error = std::current_exception();
+	}
+	guard.lock();
+	c.spec = std::move(spec);
+	c.error = error;
+	c.status = DONE;
+	done.notify_all();
+      }
+
+      /**
+       * a worker of the pool: analyse queued candidates until the speculation is discarded
+       */
+      void work() {
+	std::unique_lock<std::mutex> guard(lock);
+	for (;;) {
+	  queued.wait(guard, [this]() { return discarded || !queue.empty(); });
+	  if (discarded)
+	    return;
+	  const size_t id = queue.front();
+	  queue.pop_front();
+	  analyse(guard, candidates[id]);
+	}
+      }
+    };
+
+    Speculation::Speculation(const InputProblem& base, const AnalysisResult& res) : 
+      shared(new state(base, res)) {}
+
+    Speculation::Speculation(const ChangedProblem& base, const AnalysisResult& res) : 
+      shared(new state(base, res)) {}
+
+    Speculation::~Speculation() {
+      {
+	std::lock_guard<std::mutex> guard(shared->lock);
+	shared->discarded = true;
+	shared->cancelled = true;
+	shared->queue.clear();
+      }
+      shared->queued.notify_all();
+      for (std::thread& w : shared->workers)
+	w.join();
+    }
+
+    size_t Speculation::add(const StructChange& delta) {
+      std::lock_guard<std::mutex> guard(shared->lock);
+      const size_t id = shared->candidates.size();
+      shared->candidates.push_back({delta, state::QUEUED, SpeculativeResult(), nullptr});
+      shared->queue.push_back(id);
+
+      /* an idle worker takes it, a new one is started while there are cores left */
+      if (shared->workers.size() < std::max(1u, std::thread::hardware_concurrency()))
+	shared->workers.emplace_back(&state::work, shared.get());
+      else
+	shared->queued.notify_one();
+      return id;
+    }
+
+    SpeculativeResult Speculation::commit(size_t id) {
+      std::unique_lock<std::mutex> guard(shared->lock);
+      state::candidate& c = shared->candidates.at(id);
+      if (c.status == state::COMMITTED)
+	throw std::invalid_argument("speculative candidate already committed");
+
+      if (c.status == state::QUEUED) {
+	/* do not wait for the candidates queued before this one */
+	shared->queue.erase(std::find(shared->queue.begin(), shared->queue.end(), id));
+	shared->analyse(guard, c);
+      } else
+	shared->done.wait(guard, [&c]() { return c.status == state::DONE; });
+
+      c.status = state::COMMITTED;
+      if (c.error)
+	std::rethrow_exception(c.error);
+      return std::move(c.spec);
+    }
+  }
+}
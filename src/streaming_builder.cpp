@@ -0,0 +1,152 @@
+/*
+ * Copyright (C) 2014 uebb.tu-berlin.de.
+ *
+ * This file is part of daestruct
+ *
+ * daestruct is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * daestruct is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <daestruct/streaming_builder.hpp>
+#include <daestruct/mapped_sigma_matrix.hpp>
+
+#include <algorithm>
+#include <queue>
+#include <stdexcept>
+
+namespace daestruct {
+  namespace analysis {
+
+    /**
+     * buffered reader of a sorted run
+     */
+    struct run_reader {
+      std::FILE* file;
+      std::vector<streaming_builder::entry> buffer;
+      size_t pos = 0;
+
+      run_reader(std::FILE* f, size_t size) : file(f), buffer(size) {
+	std::rewind(file);
+	fill();
+      }
+
+      void fill() {
+	buffer.resize(buffer.capacity());
+	buffer.resize(std::fread(buffer.data(), sizeof(streaming_builder::entry), buffer.size(), file));
+	pos = 0;
+      }
+
+      bool empty() const { return pos >= buffer.size(); }
+
+      const streaming_builder::entry& top() const { return buffer[pos]; }
+
+      void pop() {
+	if (++pos >= buffer.size())
+	  fill();
+      }
+    };
+
+    streaming_builder::streaming_builder(size_t dim, size_t chunk_entries) 
+      : dimension(dim), chunk_size(std::max<size_t>(chunk_entries, 1)) {
+      chunk.reserve(chunk_size);
+    }
+
+    streaming_builder::~streaming_builder() {
+      for (std::FILE* run : runs)
+	std::fclose(run);
+    }
+
+    void streaming_builder::sort_chunk() {
+      std::sort(chunk.begin(), chunk.end(), entry_less);
+      /* the first one of equal positions has the highest derivative */
+      chunk.erase(std::unique(chunk.begin(), chunk.end(), same_position), chunk.end());
+    }
+
+    void streaming_builder::spill() {
+      sort_chunk();
+
+      std::FILE* run = std::tmpfile();
+      if (!run)
+	throw std::runtime_error("streaming_builder: cannot create a temporary file");
+
+      if (std::fwrite(chunk.data(), sizeof(entry), chunk.size(), run) != chunk.size()) {
+	std::fclose(run);
+	throw std::runtime_error("streaming_builder: cannot write a sorted run");
+      }
+
+      runs.push_back(run);
+      chunk.clear();
+    }
+
+    template<class Sink>
+    void streaming_builder::merge(Sink&& push_back) {
+      if (runs.empty()) {
+	sort_chunk();
+	for (const entry& e : chunk)
+	  push_back(e);
+	std::vector<entry>().swap(chunk);
+	return;
+      }
+
+      if (!chunk.empty())
+	spill();
+      std::vector<entry>().swap(chunk);
+
+      /* k-way merge, every reader gets an equal share of one chunk */
+      const size_t buffer_size = std::max<size_t>(chunk_size / runs.size(), 1);
+      std::vector<run_reader> readers;
+      readers.reserve(runs.size());
+      for (std::FILE* run : runs)
+	readers.emplace_back(run, buffer_size);
+
+      auto greater = [&readers](size_t a, size_t b) { return entry_less(readers[b].top(), readers[a].top()); };
+      std::priority_queue<size_t, std::vector<size_t>, decltype(greater)> heads(greater);
+      for (size_t r = 0; r < readers.size(); r++)
+	if (!readers[r].empty())
+	  heads.push(r);
+
+      bool first = true;
+      entry last = entry();
+      while (!heads.empty()) {
+	const size_t r = heads.top();
+	heads.pop();
+	const entry e = readers[r].top();
+	readers[r].pop();
+	if (!readers[r].empty())
+	  heads.push(r);
+
+	/* equal positions come in order of decreasing derivative */
+	if (first || !same_position(e, last))
+	  push_back(e);
+	first = false;
+	last = e;
+      }
+
+      for (std::FILE* run : runs)
+	std::fclose(run);
+      runs.clear();
+    }
+
+    InputProblem streaming_builder::build() {
+      InputProblem problem(dimension);
+      merge([&problem](const entry& e) { problem.sigma.push_back(e.row, e.col, e.der); });
+      return problem;
+    }
+
+    void streaming_builder::write_mapped(const std::string& path) {
+      mapped_sigma_matrix::writer out(path, dimension);
+      merge([&out](const entry& e) { out.push_back(e.row, e.col, e.der); });
+      out.close();
+    }
+  }
+}
@@ -18,6 +18,7 @@
  */
 
 #include <daestruct/variable_analysis.hpp>
+#include <daestruct/analysis_cache.hpp>
 
 #include <boost/icl/interval.hpp>
 #include <boost/icl/interval_map.hpp>
@@ -30,15 +31,46 @@ namespace daestruct {
 
 using namespace boost::icl;
 
-    AnalysisResult ChangedProblem::pryceAlgorithm() const {
-      /* solve linear assignment problem */
-      solution assignment = delta_lap(sigma, dual_rows, dual_columns, row_assignment, col_assignment);
+    void StructChange::merge(const StructChange& other) {
+      deletedRows.insert(other.deletedRows.begin(), other.deletedRows.end());
+      deletedCols.insert(other.deletedCols.begin(), other.deletedCols.end());
+
+      for (const NewRow& row : other.newRows) {
+	NewRow shifted;
+	shifted.ex_vars = row.ex_vars;
+	for (const auto& p : row.new_vars)
+	  shifted.new_vars[p.first + newVars] = p.second;
+	newRows.push_back(shifted);
+      }
+
+      newVars += other.newVars;
+    }
 
+    static AnalysisResult analyse_assignment(const ChangedProblem& problem, solution& assignment) {
+      const sigma_matrix& sigma = problem.sigma;
+      const AnalysisOptions& options = problem.options;
+      const size_t dimension = problem.dimension;
       AnalysisResult result;
       result.c.resize(dimension);
       result.d.resize(dimension);
       result.row_assignment = std::move(assignment.rowsol);
       result.col_assignment = std::move(assignment.colsol);
+      result.augmentations = assignment.augmentations;
+      result.scanned_columns = assignment.scanned_columns;
+      if (options.keep_duals) {
+	result.u = std::move(assignment.u);
+	result.v = std::move(assignment.v);
+      }
+
+      if (options.cancelled()) {
+	result.status = ANALYSIS_CANCELLED;
+	return result;
+      }
+
+      if (assignment.unassigned > 0) {
+	result.status = ANALYSIS_STRUCTURALLY_SINGULAR;
+	return result;
+      }
 
       /* run fix-point algorithm */
       /*
@@ -61,19 +93,63 @@ using namespace boost::icl;
       
       //std::cout << "Calculating smallest dual" << std::endl;
 	  
-      solveByFixedPoint(result.row_assignment, sigma, result.c, result.d);
+      if (options.offsets == OFFSETS_POTENTIALS) {
+	const std::vector<int>& u = options.keep_duals ? result.u : assignment.u;
+	const std::vector<int>& v = options.keep_duals ? result.v : assignment.v;
+	solveByPotentials(result.row_assignment, sigma, u, v, result.c, result.d);
+      } else
+	solveByFixedPoint(result.row_assignment, sigma, result.c, result.d, options.threads, options.cancel);
+
+      if (options.cancelled())
+	result.status = ANALYSIS_CANCELLED;
 
       //std::cout << "Done fixed-point" << std::endl;
       //std::cout << "Canonical: c=" << result.c << " d=" << result.d << std::endl;
       return result;
     }
 
+    AnalysisResult ChangedProblem::pryceAlgorithm(AnalysisCache& cache) const {
+      const AnalysisResult* cached = cache.lookup(sigma, options);
+      if (cached)
+	return *cached;
+
+      AnalysisResult result = pryceAlgorithm();
+      cache.store(sigma, options, result);
+      return result;
+    }
+
+    AnalysisResult ChangedProblem::pryceAlgorithm() const {
+      lap_options lap_opts;
+      lap_opts.cancel = options.cancel;
+      /* solve linear assignment problem */
+      solution assignment = warm_start ? 
+	delta_lap(sigma, std::vector<int>(dual_rows), std::vector<int>(dual_columns), 
+		  std::vector<index_t>(row_assignment), std::vector<index_t>(col_assignment), assignment_cost, 
+		  free_rows, lap_opts) 
+	: options.engine == ENGINE_COST_SCALING ? lap_cost_scaling(sigma, lap_opts) : lap(sigma, lap_opts);
+      return analyse_assignment(*this, assignment);
+    }
+
+    AnalysisResult ChangedProblem::pryceAlgorithmConsuming() {
+      if (!warm_start)
+	return pryceAlgorithm();
+
+      lap_options lap_opts;
+      lap_opts.cancel = options.cancel;
+      solution assignment = delta_lap(sigma, std::move(dual_rows), std::move(dual_columns), 
+				      std::move(row_assignment), std::move(col_assignment), assignment_cost, 
+				      free_rows, lap_opts);
+      warm_start = false;
+      return analyse_assignment(*this, assignment);
+    }
+
     ChangedProblem::ChangedProblem(const InputProblem& prob, const AnalysisResult& result,
 				   const StructChange& delta) : 
       old_columns(prob.dimension - delta.deletedCols.size()),
       old_rows(prob.dimension - delta.deletedRows.size()),      
       dimension(prob.dimension - delta.deletedRows.size() + delta.newRows.size()),
       sigma(prob.dimension - delta.deletedRows.size() + delta.newRows.size()),
+      options(prob.options),
       row_changed(prob.dimension - delta.deletedRows.size() + delta.newRows.size()) {
      
       applyDiff(prob.sigma, result, delta);
@@ -85,6 +161,7 @@ using namespace boost::icl;
       old_rows(prob.dimension - delta.deletedRows.size()),      
       dimension(prob.dimension - delta.deletedRows.size() + delta.newRows.size()),
       sigma(prob.dimension - delta.deletedRows.size() + delta.newRows.size()),
+      options(prob.options),
       row_changed(prob.dimension - delta.deletedRows.size() + delta.newRows.size()) {
      
       applyDiff(prob.sigma, result, delta);
@@ -96,8 +173,13 @@ using namespace boost::icl;
 
       row_assignment.resize(dimension, BIG);
       col_assignment.resize(dimension, BIG);
-      dual_columns.resize(dimension, BIG);
+      /* new columns only have entries in new (i.e. free) rows, any price will do */
+      dual_columns.resize(dimension, 0);
       dual_rows.resize(dimension, BIG);
+      /* the offsets of a singular problem are no feasible dual */
+      warm_start = result.status == ANALYSIS_OK;
+      /* the LAP duals that produced the assignment, if kept, otherwise u = c, v = -d */
+      const bool exact_duals = result.u.size() == oldSigma.dimension() && result.v.size() == oldSigma.dimension();
       
       for (int removed : delta.deletedCols)
 	colOffsets += make_pair(interval<int>::closed(removed, oldSigma.dimension()), -1);
@@ -105,24 +187,39 @@ using namespace boost::icl;
       for (int removed : delta.deletedRows)
 	rowOffsets += make_pair(interval<int>::closed(removed, oldSigma.dimension()), -1);
 
-      for (auto row_iter = oldSigma.rows().cbegin(); row_iter != oldSigma.rows().cend(); row_iter++) {
-	const int orig_row = row_iter - oldSigma.rows().cbegin();
+      /* columns before the first deleted one keep their index */
+      const size_t first_deleted_col = delta.deletedCols.empty() ? oldSigma.dimension() : *delta.deletedCols.begin();
+
+      for (size_t orig_row = 0; orig_row < oldSigma.dimension(); orig_row++) {
+	const sigma_matrix::row_t& orig = oldSigma.row(orig_row);
 	const int row = orig_row + rowOffsets(orig_row);
 
 	if (delta.deletedRows.count(orig_row) == 0) {
-	  dual_rows[row] = result.c[orig_row];
+	  dual_rows[row] = exact_duals ? result.u[orig_row] : result.c[orig_row];
 
-	  const int orig_assign_col = result.row_assignment[orig_row];
+	  const size_t orig_assign_col = result.row_assignment[orig_row];
 
-	  if (delta.deletedCols.count(orig_assign_col) == 0) {
+	  if (orig_assign_col < oldSigma.dimension() && delta.deletedCols.count(orig_assign_col) == 0) {
 	    const int new_assign_col = orig_assign_col + colOffsets(orig_assign_col);
 	    row_assignment[row] = new_assign_col;
 	    col_assignment[new_assign_col] = row;
-	  } else 
-	    row_assignment[row] = -1;
+	    /* both duals are tight on the assignment */
+	    assignment_cost += exact_duals ? 
+	      result.u[orig_row] + result.v[orig_assign_col] : 
+	      result.c[orig_row] - result.d[orig_assign_col];
+	  } else {
+	    row_assignment[row] = BIG;
+	    free_rows.push_back(row);
+	  }
+
+	  /* share unchanged rows with the original matrix */
+	  if (orig.begin() == orig.end() || (--orig.end()).index() < first_deleted_col) {
+	    sigma.share_row(row, oldSigma, orig_row);
+	    continue;
+	  }
 
 	  /* insert row from original matrix */
-	  for (auto col_iter = (*row_iter).begin(); col_iter != (*row_iter).end(); col_iter++)
+	  for (auto col_iter = orig.begin(); col_iter != orig.end(); col_iter++)
 	    if (delta.deletedCols.count(col_iter.index()) == 0) {
 	      const int orig_col = col_iter.index();
 	      const int column = orig_col + colOffsets(orig_col);
@@ -133,15 +230,17 @@ using namespace boost::icl;
       }
      
       for (size_t j = 0; j < result.d.size(); j++)
-	dual_columns[j + colOffsets(j)] = -result.d.at(j);
+	if (delta.deletedCols.count(j) == 0)
+	  dual_columns[j + colOffsets(j)] = exact_duals ? result.v[j] : -result.d[j];
 
       for (size_t i = 0; i < delta.newRows.size(); i++) {
 	const NewRow& nrow = delta.newRows[i];
+	free_rows.push_back(old_rows + i);
 	//std::cout << "Adding new row " << i << " to " << (old_rows + i) << std::endl;
 	for (const std::pair<int, int>& p : nrow.ex_vars) {
 	  const int orig_col = get<0>(p) ;
 	  const int col = orig_col + colOffsets(orig_col);
-	  const int min = sigma.smallest_cost_row(col);
+	  const index_t min = sigma.smallest_cost_row(col);
 	  sigma.insert(old_rows+i, col, get<1>(p)); 
 	  row_changed[col] = min != sigma.smallest_cost_row(col);
 	}
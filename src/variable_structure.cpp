@@ -24,6 +24,9 @@
 #include <daestruct/variable_analysis.hpp>
 #include <daestruct/sigma_matrix.hpp>
 #include <daestruct/c_cpp_interface.hpp>
+#include <daestruct/matrix_market.hpp>
+
+#include <fstream>
 
 using namespace daestruct::analysis;
 
@@ -63,6 +66,18 @@ extern "C" {
     diff->newRows[newEquation].new_vars[unknown] = -der;
   }
 
+  int daestruct_diff_equations(struct daestruct_diff* diff) {
+    return diff->newRows.size();
+  }
+
+  int daestruct_diff_unknowns(struct daestruct_diff* diff) {
+    return diff->newVars;
+  }
+
+  void daestruct_diff_merge(struct daestruct_diff* target, struct daestruct_diff* other) {
+    target->merge(*other);
+  }
+
   struct daestruct_changed* daestruct_change_orig(struct daestruct_input*  original, 
 						  struct daestruct_result* result, 
 						  struct daestruct_diff* diff) {
@@ -95,7 +110,67 @@ extern "C" {
     delete changed;
   }
 
+  int daestruct_changed_write(struct daestruct_changed* changed, const char* path) {
+    std::ofstream out(path);
+    write_matrix_market(changed->sigma, out);
+    out.close();
+    return out ? 0 : -1;
+  }
+
+  struct daestruct_reduced* daestruct_changed_reduce(struct daestruct_changed* changed, struct daestruct_result* result) {
+    try {
+      return new daestruct_reduced(reduce(changed->sigma, *result));
+    } catch (const std::invalid_argument&) {
+      return nullptr;
+    }
+  }
+
+  /* analysis errors cannot cross the C boundary */
   struct daestruct_result* daestruct_changed_analyse(struct daestruct_changed* problem) {
-    return static_cast<daestruct_result*>(new AnalysisResult(problem->pryceAlgorithm()));
+    try {
+      return static_cast<daestruct_result*>(new AnalysisResult(problem->pryceAlgorithm()));
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+  }
+
+  /* analysis errors cannot cross the C boundary */
+  struct daestruct_result* daestruct_changed_analyse_cached(struct daestruct_changed* problem, struct daestruct_cache* cache) {
+    try {
+      return static_cast<daestruct_result*>(new AnalysisResult(problem->pryceAlgorithm(*cache)));
+    } catch (const std::exception&) {
+      return nullptr;
+    }
+  }
+
+  struct daestruct_speculation* daestruct_speculate_orig(struct daestruct_input* original, 
+							 struct daestruct_result* result) {
+    return new daestruct_speculation(*original, *result);
+  }
+
+  struct daestruct_speculation* daestruct_speculate(struct daestruct_changed* original, 
+						    struct daestruct_result* result) {
+    return new daestruct_speculation(*original, *result);
+  }
+
+  int daestruct_speculation_add(struct daestruct_speculation* spec, struct daestruct_diff* diff) {
+    return spec->add(*diff);
+  }
+
+  /* unknown candidates and failed analyses cannot cross the C boundary */
+  struct daestruct_changed* daestruct_speculation_commit(struct daestruct_speculation* spec, int candidate, 
+							 struct daestruct_result** result) {
+    try {
+      SpeculativeResult committed = spec->commit(candidate);
+      *result = static_cast<daestruct_result*>(new AnalysisResult(std::move(committed.result)));
+      return static_cast<daestruct_changed*>(committed.problem.release());
+    } catch (const std::exception&) {
+      *result = nullptr;
+      return nullptr;
+    }
+  }
+
+  void daestruct_speculation_delete(struct daestruct_speculation* spec) {
+    delete spec;
   }
 }
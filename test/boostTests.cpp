@@ -51,18 +51,84 @@ init_unit_test_suite( int argc, char* argv[] ) {
   framework::master_test_suite().
         add( BOOST_TEST_CASE( &test_LAP_on_identity ) );
 
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_LAP_singular ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_LAP_single_entries ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_sigma_shared_rows ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_row_kernels ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_fixed_point_threads ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_offsets_from_potentials ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_LAP_cost_scaling ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_LAP_phases ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_LAP_parallel ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_LAP_karp_sipser ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_LAP_dense ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_LAP_delta_free_rows ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &test_LAP_cancelled ) );
+
   framework::master_test_suite().
         add( BOOST_TEST_CASE( &analyzePendulum ) );
 
   framework::master_test_suite().
         add( BOOST_TEST_CASE( &analyzeModelicaPendulum ) );
 
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &analyzePendulumBulk ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &reducePendulum ) );
+
   framework::master_test_suite().
         add( BOOST_TEST_CASE( &analyzeCircuit1 ) );
 
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &analyzeCircuitCached ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &analyzeCircuitSpeculative ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &analyzeCircuitMerged ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &analyzeCircuitStreamed ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &analyzeCircuitMapped ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &analyzeCircuitMatrixMarket ) );
+
 
   framework::master_test_suite().
         add( BOOST_TEST_CASE( &analyzeCompressedCircuit1 ) );
+
+  framework::master_test_suite().
+        add( BOOST_TEST_CASE( &buildRandomComponents ) );
   
   return 0;
 }
@@ -17,10 +17,23 @@
  * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
  */
 #include <daestruct/analysis.hpp>
+#include <daestruct/analysis_cache.hpp>
+#include <daestruct/variable_analysis.hpp>
+#include <daestruct/speculation.hpp>
+#include <daestruct/streaming_builder.hpp>
+#include <daestruct/mapped_sigma_matrix.hpp>
+#include <daestruct/matrix_market.hpp>
 #include <boost/test/test_tools.hpp>
 
 #include <prettyprint.hpp>
 
+#include <cstdio>
+#include <limits>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unistd.h>
+
 #include "circuitAnalysis.hpp"
 
 namespace daestruct {
@@ -109,8 +122,351 @@ namespace daestruct {
       
       BOOST_CHECK_EQUAL( res.c, std::vector<int>({1, 1, 1, 0, 0, 1, 1, 1, 0, 1}) );
 
+      /* the offsets from the LAP duals are opt-in */
+      BOOST_CHECK_EQUAL( circuit.options.offsets, OFFSETS_FIXED_POINT );
+      circuit.options.offsets = OFFSETS_POTENTIALS;
+      const AnalysisResult res2 = circuit.pryceAlgorithm();
+      BOOST_CHECK_EQUAL( res2.c, res.c );
+      BOOST_CHECK_EQUAL( res2.d, res.d );
     };
 
+    /* replace i1=i2+iL by an equation in the given variables */
+    static StructChange replaceLastEquation(const std::vector<int>& vars) {
+      StructChange change;
+      change.newVars = 0;
+      change.deletedRows.insert(9);
+      NewRow row;
+      for (int v : vars)
+	row.ex_vars[v] = 0;
+      change.newRows.push_back(row);
+      return change;
+    }
+
+    void analyzeCircuitCached() {
+      InputProblem circuit(10);
+      setCircuitIncidence(circuit);
+
+      AnalysisCache cache(2);
+      const AnalysisResult res = circuit.pryceAlgorithm(cache);
+      BOOST_CHECK_EQUAL( cache.misses, 1 );
+      BOOST_CHECK_EQUAL( res.c, std::vector<int>({1, 1, 1, 0, 0, 1, 1, 1, 0, 1}) );
+
+      /* same structure, built differently */
+      InputProblem other(10);
+      other.sigma.insert(9, 9, -2);
+      other.sigma.insert(0, 1, 0);
+      setCircuitIncidence(other);
+      other.sigma.erase(0, 1);
+      BOOST_CHECK_EQUAL( other.sigma.fingerprint(), circuit.sigma.fingerprint() );
+
+      const AnalysisResult res2 = other.pryceAlgorithm(cache);
+      BOOST_CHECK_EQUAL( cache.hits, 1 );
+      BOOST_CHECK_EQUAL( res2.c, res.c );
+      BOOST_CHECK_EQUAL( res2.d, res.d );
+      BOOST_CHECK( res.augmentations > 0 );
+      BOOST_CHECK_EQUAL( res2.augmentations, 0 );
+      BOOST_CHECK_EQUAL( res2.scanned_columns, 0 );
+
+      /* a result without duals does not answer a problem that keeps them */
+      other.options.keep_duals = true;
+      const AnalysisResult withDuals = other.pryceAlgorithm(cache);
+      BOOST_CHECK_EQUAL( cache.misses, 2 );
+      BOOST_CHECK_EQUAL( withDuals.u.size(), 10 );
+      BOOST_CHECK_EQUAL( withDuals.c, res.c );
+
+      /* replace i1=i2+iL by itself, i.e. back to the same structure */
+      ChangedProblem changed(circuit, res, replaceLastEquation({6, 7, 9}));
+      const AnalysisResult res3 = changed.pryceAlgorithm(cache);
+      BOOST_CHECK_EQUAL( cache.hits, 2 );
+      BOOST_CHECK_EQUAL( res3.c, res.c );
+
+      /* a different structure is a miss, and evicts the oldest entry eventually */
+      ChangedProblem changed2(circuit, res, replaceLastEquation({5, 6, 7}));
+      const AnalysisResult res4 = changed2.pryceAlgorithm(cache);
+      BOOST_CHECK_EQUAL( cache.misses, 3 );
+      BOOST_CHECK_EQUAL( res4.c, changed2.pryceAlgorithm().c );
+      BOOST_CHECK_EQUAL( cache.size(), 2 );
+    }
+
+    void analyzeCircuitMerged() {
+      InputProblem circuit(10);
+      setCircuitIncidence(circuit);
+      const AnalysisResult res = circuit.pryceAlgorithm();
+
+      /* i1=i2+iL stays, but a new y = iL is added */
+      StructChange first = replaceLastEquation({6, 7, 9});
+      first.newVars = 1;
+      NewRow y;
+      y.new_vars[0] = 0;
+      y.ex_vars[9] = 0;
+      first.newRows.push_back(y);
+
+      /* a new x = der(u0) */
+      StructChange second;
+      second.newVars = 1;
+      NewRow x;
+      x.new_vars[0] = 0;
+      x.ex_vars[0] = -1;
+      second.newRows.push_back(x);
+
+      /* one after the other */
+      ChangedProblem afterFirst(circuit, res, first);
+      const AnalysisResult firstResult = afterFirst.pryceAlgorithm();
+      ChangedProblem afterSecond(afterFirst, firstResult, second);
+      const AnalysisResult expected = afterSecond.pryceAlgorithm();
+
+      /* at once */
+      StructChange merged = first;
+      merged.merge(second);
+      BOOST_CHECK_EQUAL( merged.newVars, 2 );
+      BOOST_CHECK_EQUAL( merged.newRows.size(), 3 );
+      BOOST_CHECK_EQUAL( merged.newRows[2].new_vars.count(1), 1 );
+
+      ChangedProblem both(circuit, res, merged);
+      const AnalysisResult result = both.pryceAlgorithm();
+
+      BOOST_CHECK_EQUAL( both.dimension, afterSecond.dimension );
+      BOOST_CHECK_EQUAL( both.sigma.fingerprint(), afterSecond.sigma.fingerprint() );
+      BOOST_CHECK_EQUAL( result.c, expected.c );
+      BOOST_CHECK_EQUAL( result.d, expected.d );
+      BOOST_CHECK( result.u.empty() );
+
+      /* warm-started with the LAP duals */
+      circuit.options.keep_duals = true;
+      const AnalysisResult withDuals = circuit.pryceAlgorithm();
+      BOOST_CHECK_EQUAL( withDuals.u.size(), 10 );
+      BOOST_CHECK_EQUAL( withDuals.v.size(), 10 );
+
+      ChangedProblem bothWithDuals(circuit, withDuals, merged);
+      BOOST_CHECK( bothWithDuals.options.keep_duals );
+      const AnalysisResult result2 = bothWithDuals.pryceAlgorithm();
+      BOOST_CHECK_EQUAL( result2.augmentations, 3 );
+      BOOST_CHECK_EQUAL( result2.u.size(), bothWithDuals.dimension );
+      BOOST_CHECK_EQUAL( result2.c, expected.c );
+      BOOST_CHECK_EQUAL( result2.d, expected.d );
+
+      /* the warm start is copied, analysing again gives the same result */
+      const ChangedProblem& constWithDuals = bothWithDuals;
+      const AnalysisResult result3 = constWithDuals.pryceAlgorithm();
+      BOOST_CHECK_EQUAL( result3.augmentations, result2.augmentations );
+      BOOST_CHECK_EQUAL( result3.u, result2.u );
+
+      /* unless it is consumed */
+      const AnalysisResult result4 = bothWithDuals.pryceAlgorithmConsuming();
+      BOOST_CHECK_EQUAL( result4.augmentations, result2.augmentations );
+      BOOST_CHECK_EQUAL( result4.c, expected.c );
+      BOOST_CHECK( !bothWithDuals.warm_start );
+    }
+
+    void analyzeCircuitSpeculative() {
+      InputProblem circuit(10);
+      setCircuitIncidence(circuit);
+      const AnalysisResult res = circuit.pryceAlgorithm();
+
+      const StructChange same = replaceLastEquation({6, 7, 9});
+      const StructChange other = replaceLastEquation({5, 6, 7});
+
+      Speculation spec(circuit, res);
+      const size_t first = spec.add(same);
+      const size_t second = spec.add(other);
+      BOOST_CHECK( first != second );
+
+      SpeculativeResult taken = spec.commit(second);
+      ChangedProblem expected(circuit, res, other);
+      const AnalysisResult expectedResult = expected.pryceAlgorithm();
+      BOOST_CHECK_EQUAL( taken.problem->dimension, expected.dimension );
+      BOOST_CHECK_EQUAL( taken.result.c, expectedResult.c );
+      BOOST_CHECK_EQUAL( taken.result.d, expectedResult.d );
+
+      BOOST_CHECK_THROW( spec.commit(second), std::invalid_argument );
+      /* the flag that cancels discarded candidates dies with the speculation */
+      BOOST_CHECK( taken.problem->options.cancel == nullptr );
+
+      std::atomic<bool> cancel(true);
+      InputProblem cancelled(circuit);
+      cancelled.options.cancel = &cancel;
+      BOOST_CHECK_EQUAL( cancelled.pryceAlgorithm().status, ANALYSIS_CANCELLED );
+      ChangedProblem cancelledChange(circuit, res, other);
+      cancelledChange.options.cancel = &cancel;
+      BOOST_CHECK_EQUAL( cancelledChange.pryceAlgorithm().status, ANALYSIS_CANCELLED );
+
+      /* speculate on top of the committed problem, then discard everything */
+      {
+	Speculation next(*taken.problem, taken.result);
+	for (int k = 0; k < 16; k++)
+	  next.add(k % 2 ? same : other);
+	SpeculativeResult last = next.commit(15);
+	BOOST_CHECK_EQUAL( last.problem->dimension, taken.problem->dimension );
+      }
+    }
+
+    void analyzeCircuitStreamed() {
+      InputProblem circuit(10);
+      setCircuitIncidence(circuit);
+      const AnalysisResult res = circuit.pryceAlgorithm();
+
+      /* all entries backwards, with lower duplicates, three at a time */
+      streaming_builder builder(10, 3);
+      for (int i = 9; i >= 0; i--) {
+	const auto& row = circuit.sigma.row(i);
+	for (auto it = row.begin(); it != row.end(); ++it) {
+	  builder.append(i, it.index(), -*it - 1);
+	  builder.append(i, it.index(), -*it);
+	}
+      }
+      BOOST_CHECK( builder.spilled_runs() > 1 );
+
+      /* entries outside of the problem are rejected before they reach the matrix */
+      BOOST_CHECK_THROW( builder.append(10, 0, 0), std::runtime_error );
+      BOOST_CHECK_THROW( builder.append(0, 10, 0), std::runtime_error );
+      if (sizeof(der_t) <= sizeof(int))
+	BOOST_CHECK_THROW( builder.append(0, 0, std::numeric_limits<int>::min()), std::runtime_error );
+
+      InputProblem streamed = builder.build();
+      BOOST_CHECK_EQUAL( builder.spilled_runs(), 0 );
+      BOOST_CHECK_EQUAL( streamed.sigma.fingerprint(), circuit.sigma.fingerprint() );
+
+      const AnalysisResult res2 = streamed.pryceAlgorithm();
+      BOOST_CHECK_EQUAL( res2.c, res.c );
+      BOOST_CHECK_EQUAL( res2.d, res.d );
+
+      /* small enough for a single chunk */
+      streaming_builder small(10);
+      for (int i = 0; i < 10; i++) {
+	const auto& row = circuit.sigma.row(i);
+	for (auto it = row.begin(); it != row.end(); ++it)
+	  small.append(i, it.index(), -*it);
+      }
+      BOOST_CHECK_EQUAL( small.build().sigma.fingerprint(), circuit.sigma.fingerprint() );
+      BOOST_CHECK_EQUAL( small.spilled_runs(), 0 );
+    }
+
+    /* a fresh file name for a temporary matrix file */
+    static std::string temporaryFile() {
+      char name[] = "/tmp/daestruct_test_XXXXXX";
+      const int fd = mkstemp(name);
+      BOOST_REQUIRE( fd >= 0 );
+      close(fd);
+      return name;
+    }
+
+    void analyzeCircuitMapped() {
+      InputProblem circuit(10);
+      setCircuitIncidence(circuit);
+      const AnalysisResult res = circuit.pryceAlgorithm();
+
+      const std::string path = temporaryFile();
+      mapped_sigma_matrix::write(circuit.sigma, path);
+      {
+	MappedProblem mapped(path);
+	BOOST_CHECK_EQUAL( mapped.dimension(), 10 );
+	BOOST_CHECK_EQUAL( mapped.sigma.nonzeros(), 23 );
+	BOOST_CHECK_EQUAL( mapped.sigma.fingerprint(), circuit.sigma.fingerprint() );
+	BOOST_CHECK_EQUAL( mapped.sigma(3, 9), -1 );
+	BOOST_CHECK_EQUAL( mapped.sigma(3, 8), BIG );
+	for (size_t j = 0; j < 10; j++)
+	  BOOST_CHECK_EQUAL( mapped.sigma.smallest_cost_row(j), circuit.sigma.smallest_cost_row(j) );
+
+	const AnalysisResult res2 = mapped.pryceAlgorithm();
+	BOOST_CHECK_EQUAL( res2.status, ANALYSIS_OK );
+	BOOST_CHECK_EQUAL( res2.c, res.c );
+	BOOST_CHECK_EQUAL( res2.d, res.d );
+      }
+
+      /* straight from a stream */
+      streaming_builder builder(10, 4);
+      for (int i = 9; i >= 0; i--) {
+	const auto& row = circuit.sigma.row(i);
+	for (auto it = row.begin(); it != row.end(); ++it)
+	  builder.append(i, it.index(), -*it);
+      }
+      builder.write_mapped(path);
+      {
+	MappedProblem streamed(path);
+	BOOST_CHECK_EQUAL( streamed.sigma.fingerprint(), circuit.sigma.fingerprint() );
+	BOOST_CHECK_EQUAL( streamed.pryceAlgorithm().c, res.c );
+      }
+
+      /* an unfinished file is rejected */
+      {
+	mapped_sigma_matrix::writer unfinished(path, 10);
+	unfinished.push_back(0, 0, 0);
+
+	/* so are unsorted or repeated columns of a row */
+	unfinished.push_back(0, 3, 0);
+	BOOST_CHECK_THROW( unfinished.push_back(0, 3, -1), std::runtime_error );
+	BOOST_CHECK_THROW( unfinished.push_back(0, 1, 0), std::runtime_error );
+	unfinished.push_back(1, 1, 0);
+      }
+      BOOST_CHECK_THROW( MappedProblem broken(path), std::runtime_error );
+
+      std::remove(path.c_str());
+    }
+
+    void analyzeCircuitMatrixMarket() {
+      InputProblem circuit(10);
+      setCircuitIncidence(circuit);
+      const AnalysisResult res = circuit.pryceAlgorithm();
+
+      std::ostringstream out;
+      write_matrix_market(circuit.sigma, out);
+      const std::string text = out.str();
+      BOOST_CHECK_EQUAL( text.substr(0, text.find('\n')), "%%MatrixMarket matrix coordinate integer general" );
+
+      /* the body is split between more threads than it has lines */
+      for (unsigned threads = 1; threads <= 32; threads *= 2) {
+	const InputProblem read = parse_matrix_market(text.data(), text.data() + text.size(), threads);
+	BOOST_CHECK_EQUAL( read.dimension, 10 );
+	BOOST_CHECK_EQUAL( read.sigma.fingerprint(), circuit.sigma.fingerprint() );
+      }
+
+      /* any order, comments, duplicates keep the highest derivative */
+      const std::string shuffled = 
+	"%%MatrixMarket matrix coordinate integer general\n"
+	"% comment\n"
+	"2 2 4\n"
+	"2 2 0\r\n"
+	"\n"
+	"1 2 1\n"
+	"% another comment\n"
+	"1 1 0\n"
+	"1 2 0";
+      const InputProblem small = parse_matrix_market(shuffled.data(), shuffled.data() + shuffled.size(), 2);
+      BOOST_CHECK_EQUAL( small.sigma(0, 1), -1 );
+      BOOST_CHECK_EQUAL( small.sigma(1, 0), BIG );
+      BOOST_CHECK_EQUAL( small.sigma(1, 1), 0 );
+
+      const std::string pattern = "%%MatrixMarket matrix coordinate pattern general\n2 2 2\n1 2\n2 1\n";
+      BOOST_CHECK_EQUAL( parse_matrix_market(pattern.data(), pattern.data() + pattern.size()).sigma(1, 0), 0 );
+
+      const std::string malformed[] = {
+	"%%MatrixMarket matrix coordinate real general\n1 1 1\n1 1 1.5\n",
+	"%%MatrixMarket matrix coordinate integer general\n2 3 0\n",
+	"%%MatrixMarket matrix coordinate integer general\n2 2 1\n1 3 0\n",
+	"%%MatrixMarket matrix coordinate integer general\n2 2 1\n1 1 x\n",
+	"%%MatrixMarket matrix coordinate integer general\n2 2 2\n1 1 0\n",
+	"1 1 1\n"
+      };
+      for (const std::string& m : malformed)
+	BOOST_CHECK_THROW( parse_matrix_market(m.data(), m.data() + m.size()), std::runtime_error );
+
+      /* both file formats */
+      const std::string path = temporaryFile();
+      {
+	std::ofstream file(path);
+	file << text;
+      }
+      BOOST_CHECK_EQUAL( read_problem(path).pryceAlgorithm().c, res.c );
+
+      mapped_sigma_matrix::write(circuit.sigma, path);
+      BOOST_CHECK_EQUAL( read_problem(path).sigma.fingerprint(), circuit.sigma.fingerprint() );
+      std::remove(path.c_str());
+
+      std::ostringstream result;
+      write_matrix_market(res, result);
+      BOOST_CHECK( result.str().find("\n10 3\n1\n1\n") != std::string::npos );
+    }
+
   }
 
 }
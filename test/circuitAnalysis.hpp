@@ -53,6 +53,36 @@ namespace daestruct {
      */
     void analyzeCircuit1();
 
+    /**
+     * Analyze the same circuit repeatedly through an AnalysisCache
+     */
+    void analyzeCircuitCached();
+
+    /**
+     * Apply two changes of the same circuit at once
+     */
+    void analyzeCircuitMerged();
+
+    /**
+     * Analyze changes of the same circuit speculatively
+     */
+    void analyzeCircuitSpeculative();
+
+    /**
+     * Build the same circuit through a streaming_builder with spilled runs
+     */
+    void analyzeCircuitStreamed();
+
+    /**
+     * Analyze the same circuit from a memory-mapped matrix file
+     */
+    void analyzeCircuitMapped();
+
+    /**
+     * Read and write the same circuit as Matrix Market and binary files
+     */
+    void analyzeCircuitMatrixMarket();
+
   }
 
 }
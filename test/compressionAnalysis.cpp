@@ -20,7 +20,10 @@
 #include <boost/test/test_tools.hpp>
 
 #include <prettyprint.hpp>
+#include <algorithm>
+#include <cstdlib>
 
+#include "lap.hpp"
 #include "compressionAnalysis.hpp"
 
 namespace daestruct {
@@ -156,5 +159,56 @@ namespace daestruct {
       delete sc;
     }
 
+
+    void buildRandomComponents() {
+      std::srand(8);
+      for (int round = 0; round < 40; round++) {
+	const size_t q = 1 + std::rand() % 5, p = std::rand() % 40;
+	compressible_builder builder(q, p);
+
+	/* the same equations in the square form with an identity row per other public variable */
+	sigma_matrix padded(p + q);
+	for (size_t i = 0; i < p + 1; i++) {
+	  for (int k = 0; k < 2 + round % 3; k++) {
+	    const int j = std::rand() % (p + q), val = -(std::rand() % 3);
+	    if (j < int(q))
+	      builder.set_public_incidence(i, j, val);
+	    else
+	      builder.set_private_incidence(i, j - q, val);
+	    padded.insert(i, j, val);
+	  }
+	}
+
+	const compressible c = builder.build();
+	for (size_t j = 0; j < q; j++) {
+	  size_t s_row = p + 1;
+	  for (size_t pub_j = 0; pub_j < q; pub_j++)
+	    if (pub_j != j)
+	      padded.insert(s_row++, pub_j, 0);
+	  const solution expected = lap(padded);
+	  s_row = p + 1;
+	  for (size_t pub_j = 0; pub_j < q; pub_j++)
+	    if (pub_j != j)
+	      padded.erase(s_row++, pub_j);
+
+	  BOOST_CHECK_EQUAL( c.feasible[j], expected.unassigned == 0 );
+	  if (!c.feasible[j])
+	    continue;
+	  BOOST_CHECK_EQUAL( c.cost[j], expected.cost );
+
+	  /* M_j assigns j and every private variable once, on entries of the component */
+	  std::vector<index_t> columns(c.assignment(j), c.assignment(j) + p + 1);
+	  std::sort(columns.begin(), columns.end());
+	  BOOST_CHECK( std::adjacent_find(columns.begin(), columns.end()) == columns.end() );
+	  BOOST_CHECK( std::find(columns.begin(), columns.end(), j) != columns.end() );
+	  int cost = 0;
+	  for (size_t i = 0; i < p + 1; i++) {
+	    BOOST_REQUIRE( c.sigma.find_element(i, c.assignment(j)[i]) );
+	    cost += c.sigma(i, c.assignment(j)[i]);
+	  }
+	  BOOST_CHECK_EQUAL( cost, c.cost[j] );
+	}
+      }
+    }
   }
 }
@@ -54,6 +54,12 @@ namespace daestruct {
      */
     void analyzeCompressedCircuit1();
 
+    /**
+     * Build random components and compare every M_q with the LAP of the 
+     * square matrix bordered by identity rows for the other public variables
+     */
+    void buildRandomComponents();
+
   }
 
 }
@@ -17,7 +17,9 @@
  * along with daestruct. If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <daestruct.h>
 #include <daestruct/analysis.hpp>
+#include <daestruct/reduced_system.hpp>
 #include <boost/test/test_tools.hpp>
 
 #include <string>
@@ -113,6 +115,121 @@ namespace daestruct {
       BOOST_CHECK_EQUAL( res.d, std::vector<int>({2,2,1,1,0}) );
       BOOST_CHECK_EQUAL( res.c, std::vector<int>({2,1,1,0,0}) );
     }
+
+    void analyzePendulumBulk() {
+      struct daestruct_input* pendulum = daestruct_input_create(3);
+      daestruct_input_set(pendulum, 0, 0, 0);
+      daestruct_input_set(pendulum, 1, 0, 0);
+      daestruct_input_set(pendulum, 0, 1, 2);
+      daestruct_input_set(pendulum, 2, 1, 0);
+      daestruct_input_set(pendulum, 1, 2, 2);
+      daestruct_input_set(pendulum, 2, 2, 0);
+
+      struct daestruct_result* result = daestruct_analyse(pendulum);
+      BOOST_REQUIRE_EQUAL( daestruct_result_dimension(result), 3 );
+
+      std::vector<int> c(3), d(3), rows(3), cols(3);
+      daestruct_result_copy_equation_indices(result, c.data());
+      daestruct_result_copy_variable_indices(result, d.data());
+      daestruct_result_copy_row_assignment(result, rows.data());
+      daestruct_result_copy_col_assignment(result, cols.data());
+
+      BOOST_CHECK_EQUAL( c, std::vector<int>({2,0,0}) );
+      BOOST_CHECK_EQUAL( d, std::vector<int>({2,2,0}) );
+      BOOST_CHECK_EQUAL( std::vector<int>(daestruct_result_equation_indices(result), 
+					  daestruct_result_equation_indices(result) + 3), c );
+      BOOST_CHECK_EQUAL( std::vector<int>(daestruct_result_variable_indices(result), 
+					  daestruct_result_variable_indices(result) + 3), d );
+
+      for (int i = 0; i < 3; i++)
+	BOOST_CHECK_EQUAL( cols[rows[i]], i );
+
+      BOOST_CHECK_EQUAL( daestruct_result_components(result), 0 );
+
+      daestruct_result_delete(result);
+      daestruct_input_delete(pendulum);
+    }
+
+    /* every block may only depend on the variables of earlier blocks */
+    static void checkBlockOrder(const InputProblem& p, const AnalysisResult& res, const ReducedSystem& r) {
+      std::vector<size_t> block(p.dimension);
+      for (size_t b = 0; b < r.blocks(); b++)
+	for (size_t k = r.block_start[b]; k < r.block_start[b + 1]; k++)
+	  block[r.block_equations[k]] = b;
+
+      for (int i = 0; i < p.dimension; i++) {
+	const sigma_matrix::row_t& row = p.sigma.row(i);
+	for (auto it = row.begin(); it != row.end(); ++it)
+	  if (res.d[it.index()] - res.c[i] == -*it)
+	    BOOST_CHECK( block[res.col_assignment[it.index()]] <= block[i] );
+      }
+    }
+
+    void reducePendulum() {
+      InputProblem pendulum(3);
+      setIncidence(pendulum);
+      const AnalysisResult res = pendulum.pryceAlgorithm();
+      const ReducedSystem r = reduce(pendulum.sigma, res);
+
+      /* x² + y² = 1 and its two derivatives, x, y up to the second derivative */
+      BOOST_CHECK_EQUAL( r.equation_start, std::vector<index_t>({0, 3, 4, 5}) );
+      BOOST_CHECK_EQUAL( r.variable_start, std::vector<index_t>({0, 3, 6, 7}) );
+      BOOST_CHECK_EQUAL( r.equations(), 5 );
+      BOOST_CHECK_EQUAL( r.variables(), 7 );
+      BOOST_CHECK_EQUAL( r.degrees_of_freedom(), 2 );
+
+      /* d²/dt² (x² + y²) contains x'' and y'' */
+      BOOST_CHECK_EQUAL( std::vector<index_t>(r.columns.begin() + r.row_start[2], r.columns.begin() + r.row_start[3]), 
+			 std::vector<index_t>({2, 5}) );
+
+      /* all equations are coupled in the highest derivatives */
+      BOOST_CHECK_EQUAL( r.blocks(), 1 );
+      checkBlockOrder(pendulum, res, r);
+
+      /* one of x and y becomes a dummy derivative on both levels */
+      BOOST_CHECK_EQUAL( r.levels(), 2 );
+      BOOST_CHECK_EQUAL( r.dummy_start, std::vector<index_t>({0, 1, 2}) );
+      BOOST_CHECK_EQUAL( r.dummy_variables[0], r.dummy_variables[1] );
+      BOOST_CHECK( r.dummy_variables[0] < 2 );
+      BOOST_CHECK_EQUAL( r.dummy_orders, std::vector<int>({2, 1}) );
+
+      /* the Modelica pendulum is split into blocks */
+      InputProblem modelica(5);
+      setIncidenceModelica(modelica);
+      const AnalysisResult res2 = modelica.pryceAlgorithm();
+      const ReducedSystem r2 = reduce(modelica.sigma, res2);
+      BOOST_CHECK_EQUAL( r2.equations(), 9 );
+      BOOST_CHECK_EQUAL( r2.variables(), 11 );
+      BOOST_CHECK_EQUAL( r2.degrees_of_freedom(), 2 );
+      BOOST_CHECK_EQUAL( r2.dummy_start, std::vector<index_t>({0, 3, 4}) );
+      checkBlockOrder(modelica, res2, r2);
+
+      /* through the C interface */
+      struct daestruct_input* input = daestruct_input_create(3);
+      daestruct_input_set(input, 0, 0, 0);
+      daestruct_input_set(input, 1, 0, 0);
+      daestruct_input_set(input, 0, 1, 2);
+      daestruct_input_set(input, 2, 1, 0);
+      daestruct_input_set(input, 1, 2, 2);
+      daestruct_input_set(input, 2, 2, 0);
+      struct daestruct_result* result = daestruct_analyse(input);
+      struct daestruct_reduced* reduced = daestruct_reduce(input, result);
+      BOOST_REQUIRE( reduced );
+      BOOST_CHECK_EQUAL( daestruct_reduced_equations(reduced), 5 );
+      BOOST_CHECK_EQUAL( daestruct_reduced_degrees_of_freedom(reduced), 2 );
+
+      std::vector<int> variables(daestruct_reduced_dummies(reduced)), orders(variables.size());
+      daestruct_reduced_copy_dummies(reduced, variables.data(), orders.data());
+      BOOST_CHECK_EQUAL( orders, std::vector<int>({2, 1}) );
+
+      std::vector<int> row_start(daestruct_reduced_equations(reduced) + 1), columns(daestruct_reduced_nonzeros(reduced));
+      daestruct_reduced_copy_incidence(reduced, row_start.data(), columns.data());
+      BOOST_CHECK_EQUAL( row_start.back(), 10 );
+
+      daestruct_reduced_delete(reduced);
+      daestruct_result_delete(result);
+      daestruct_input_delete(input);
+    }
     
   }
 }
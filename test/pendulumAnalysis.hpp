@@ -33,6 +33,17 @@ namespace daestruct {
      * described as in Modelica (i.e. maximum source derivative = 1)
      */
     void analyzeModelicaPendulum();
+
+    /**
+     * Run structural analysis of the cartesian pendulum through the C interface
+     * and read the results in bulk
+     */
+    void analyzePendulumBulk();
+
+    /**
+     * Build the index-reduced system of both pendulums
+     */
+    void reducePendulum();
   }
 }
 #endif
@@ -20,8 +20,12 @@
 #include <daestruct/analysis.hpp>
 #include <boost/test/test_tools.hpp>
 #include <prettyprint.hpp>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 
 #include "lap.hpp"
+#include "row_kernels.hpp"
 #include "test_lap.hpp"
 
 namespace daestruct {
@@ -51,8 +55,8 @@ namespace daestruct {
       sigma.insert(2, 1, -3);
       sigma.insert(2, 2, -1);
 
-      std::vector<size_t> rowsol({BIG, 0, 1});
-      std::vector<size_t> colsol({ 1, 2, BIG});
+      std::vector<index_t> rowsol({BIG, 0, 1});
+      std::vector<index_t> colsol({ 1, 2, BIG});
 
       std::vector<int> u({ 0, 0, 0});
       std::vector<int> v({ -2, -3, 0});
@@ -60,8 +64,8 @@ namespace daestruct {
       solution assignment = delta_lap(sigma, u, v, rowsol, colsol);
       
       BOOST_CHECK_EQUAL( assignment.cost, -5 );
-      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<size_t>({0,2,1}) );      
-      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<size_t>({0,2,1}) );      
+      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<index_t>({0,2,1}) );      
+      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<index_t>({0,2,1}) );      
     }
 
     void test_LAP_better_delta() {
@@ -82,8 +86,8 @@ namespace daestruct {
 
       solution assignment = lap(sigma);
       
-      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<size_t>({1,0}) );
-      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<size_t>({1,0}) );      
+      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<index_t>({1,0}) );
+      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<index_t>({1,0}) );      
       BOOST_CHECK_EQUAL( assignment.cost, 4);
 
       sigma_matrix sigma2 ( 2 );
@@ -102,10 +106,10 @@ namespace daestruct {
       sigma2.insert(1, 0, 1);
       sigma2.insert(1, 1, 3);
 
-      solution delta_assignment = delta_lap(sigma2, assignment.u, assignment.v, std::vector<size_t>({1, BIG}), std::vector<size_t>({BIG,0}));
+      solution delta_assignment = delta_lap(sigma2, assignment.u, assignment.v, std::vector<index_t>({1, BIG}), std::vector<index_t>({BIG,0}));
 
-      BOOST_CHECK_EQUAL( delta_assignment.rowsol, std::vector<size_t>({0,1}) );
-      BOOST_CHECK_EQUAL( delta_assignment.colsol, std::vector<size_t>({0,1}) );      
+      BOOST_CHECK_EQUAL( delta_assignment.rowsol, std::vector<index_t>({0,1}) );
+      BOOST_CHECK_EQUAL( delta_assignment.colsol, std::vector<index_t>({0,1}) );      
       BOOST_CHECK_EQUAL( delta_assignment.cost, 3);
     }
 
@@ -133,8 +137,8 @@ namespace daestruct {
       sigma.insert(2, 1, 3);
       sigma.insert(2, 2, 1);
 
-      std::vector<size_t> rowsol({BIG, 0, 1});
-      std::vector<size_t> colsol({ 1, 2, BIG});
+      std::vector<index_t> rowsol({BIG, 0, 1});
+      std::vector<index_t> colsol({ 1, 2, BIG});
 
       std::vector<int> u({ 0, 0, 0});
       std::vector<int> v({ 2, 3, 0});
@@ -142,8 +146,8 @@ namespace daestruct {
       solution assignment = delta_lap(sigma, u, v, rowsol, colsol);
       
       BOOST_CHECK_EQUAL( assignment.cost, 4 );
-      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<size_t>({1,0,2}) );      
-      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<size_t>({1,0,2}) );      
+      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<index_t>({1,0,2}) );      
+      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<index_t>({1,0,2}) );      
     }
     
     void test_LAP_taxi_example() {
@@ -182,11 +186,11 @@ namespace daestruct {
 
       solution assignment = lap(sigma);
 
-      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<size_t>({0,2,3,1,4}) );      
-      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<size_t>({0,3,1,2,4}) );
+      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<index_t>({0,2,3,1,4}) );      
+      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<index_t>({0,3,1,2,4}) );
 
-      std::vector<size_t> partial_r(assignment.rowsol);
-      std::vector<size_t> partial_c(assignment.colsol);
+      std::vector<index_t> partial_r(assignment.rowsol);
+      std::vector<index_t> partial_c(assignment.colsol);
       std::vector<int> u(assignment.u);
       std::vector<int> v(assignment.v);
 
@@ -194,9 +198,25 @@ namespace daestruct {
       partial_c[0] = BIG;
       solution assignment2 = delta_lap(sigma, u, v, partial_r, partial_c);
 
-      BOOST_CHECK_EQUAL( assignment2.rowsol, std::vector<size_t>({0,2,3,1,4}) );      
-      BOOST_CHECK_EQUAL( assignment2.colsol, std::vector<size_t>({0,3,1,2,4}) );
-
+      BOOST_CHECK_EQUAL( assignment2.rowsol, std::vector<index_t>({0,2,3,1,4}) );      
+      BOOST_CHECK_EQUAL( assignment2.colsol, std::vector<index_t>({0,3,1,2,4}) );
+
+      /* the same, handing over the vectors of the solution */
+      const int cost = assignment.cost - sigma(1, 2) - sigma(3, 1);
+      assignment.rowsol[1] = assignment.rowsol[3] = BIG;
+      assignment.colsol[2] = assignment.colsol[1] = BIG;
+      solution assignment3 = delta_lap(sigma, std::move(assignment.u), std::move(assignment.v), 
+				       std::move(assignment.rowsol), std::move(assignment.colsol), cost);
+
+      BOOST_CHECK_EQUAL( assignment3.unassigned, 0 );
+      BOOST_CHECK_EQUAL( assignment3.cost, lap(sigma).cost );
+      BOOST_CHECK_EQUAL( assignment3.rowsol, std::vector<index_t>({0,2,3,1,4}) );      
+      for (index_t i = 0; i < 5; i++) {
+	const index_t j = assignment3.rowsol[i];
+	BOOST_CHECK_EQUAL( assignment3.u[i] + assignment3.v[j], sigma(i, j) );
+	for (index_t k = 0; k < 5; k++)
+	  BOOST_CHECK( assignment3.u[i] + assignment3.v[k] <= sigma(i, k) );
+      }
     }
 
     void test_LAP_on_lifted_identity() {
@@ -224,8 +244,8 @@ namespace daestruct {
 
       solution assignment = lap(sigma);
       
-      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<size_t>({0,1,2,3,4}) );
-      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<size_t>({0,1,2,3,4}) );      
+      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<index_t>({0,1,2,3,4}) );
+      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<index_t>({0,1,2,3,4}) );      
     }
     
     void test_LAP_on_identity() {
@@ -239,11 +259,11 @@ namespace daestruct {
 
       solution assignment = lap(sigma);
       
-      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<size_t>({0,1,2,3,4}) );
-      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<size_t>({0,1,2,3,4}) );
+      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<index_t>({0,1,2,3,4}) );
+      BOOST_CHECK_EQUAL( assignment.colsol, std::vector<index_t>({0,1,2,3,4}) );
       
-      std::vector<size_t> partial_r(assignment.rowsol);
-      std::vector<size_t> partial_c(assignment.colsol);
+      std::vector<index_t> partial_r(assignment.rowsol);
+      std::vector<index_t> partial_c(assignment.colsol);
       std::vector<int> u(assignment.u);
       std::vector<int> v(assignment.v);
 
@@ -251,8 +271,8 @@ namespace daestruct {
       partial_c[2] = BIG;
       solution assignment2 = delta_lap(sigma, u, v, partial_r, partial_c);
 
-      BOOST_CHECK_EQUAL( assignment2.rowsol, std::vector<size_t>({0,1,2,3,4}) );
-      BOOST_CHECK_EQUAL( assignment2.colsol, std::vector<size_t>({0,1,2,3,4}) );
+      BOOST_CHECK_EQUAL( assignment2.rowsol, std::vector<index_t>({0,1,2,3,4}) );
+      BOOST_CHECK_EQUAL( assignment2.colsol, std::vector<index_t>({0,1,2,3,4}) );
 
       u = assignment2.u;
       v = assignment2.v;
@@ -260,8 +280,529 @@ namespace daestruct {
       partial_c[1] = BIG;
       solution assignment3 = delta_lap(sigma, u, v, partial_r, partial_c);
 
-      BOOST_CHECK_EQUAL( assignment3.rowsol, std::vector<size_t>({0,1,2,3,4}) );
-      BOOST_CHECK_EQUAL( assignment3.colsol, std::vector<size_t>({0,1,2,3,4}) );
+      BOOST_CHECK_EQUAL( assignment3.rowsol, std::vector<index_t>({0,1,2,3,4}) );
+      BOOST_CHECK_EQUAL( assignment3.colsol, std::vector<index_t>({0,1,2,3,4}) );
+    }
+
+    void test_LAP_singular() {
+      sigma_matrix sigma ( 3 );
+
+      /*
+	    1  2  3
+	   ---------
+	A | 0  X  X |
+	  |---------|
+	B |-1  X  X |
+	  |---------|
+	C | 0 -1  0 |
+	  -----------
+       */
+      sigma.insert(0, 0, 0);
+      sigma.insert(1, 0, -1);
+      sigma.insert(2, 0, 0);
+      sigma.insert(2, 1, -1);
+      sigma.insert(2, 2, 0);
+
+      solution assignment = lap(sigma);
+      BOOST_CHECK_EQUAL( assignment.unassigned, 1 );
+
+      analysis::InputProblem problem(3);
+      problem.sigma = sigma;
+      const analysis::AnalysisResult result = problem.pryceAlgorithm();
+      BOOST_CHECK_EQUAL( result.status, analysis::ANALYSIS_STRUCTURALLY_SINGULAR );
+
+      /*
+	    1  2  3
+	   ---------
+	A | X  0 -2 |
+	B | X  0  0 |
+	C | X -2  0 |
+	   ---------
+	three rows on two columns: the augmenting row reduction used to lower
+	the reductions of 2 and 3 in turns forever
+       */
+      sigma_matrix cycling ( 3 );
+      cycling.insert(0, 1, 0);
+      cycling.insert(0, 2, -2);
+      cycling.insert(1, 1, 0);
+      cycling.insert(1, 2, 0);
+      cycling.insert(2, 1, -2);
+      cycling.insert(2, 2, 0);
+
+      lap_options sparse;
+      sparse.dense_small_matrices = false;
+      const solution maximal = lap(cycling, sparse);
+      BOOST_CHECK_EQUAL( maximal.unassigned, 1 );
+      BOOST_CHECK_EQUAL( maximal.cost, -4 );
+    }
+
+    void test_LAP_single_entries() {
+      sigma_matrix sigma ( 3 );
+
+      /*
+	    1  2  3
+	   ---------
+	A |-2  X  X |
+	  |---------|
+	B |-1 -1  X |
+	  |---------|
+	C | X -1  0 |
+	  -----------
+       */
+      sigma.insert(0, 0, -2);
+      sigma.insert(1, 0, -1);
+      sigma.insert(1, 1, -1);
+      sigma.insert(2, 1, -1);
+      sigma.insert(2, 2, 0);
+
+      solution assignment = lap(sigma);
+      BOOST_CHECK_EQUAL( assignment.unassigned, 0 );
+      BOOST_CHECK_EQUAL( assignment.cost, -3 );
+      BOOST_CHECK_EQUAL( assignment.rowsol, std::vector<index_t>({0,1,2}) );
+
+      /* no phantom prices from absent entries */
+      for (size_t k = 0; k < 3; k++) {
+	BOOST_CHECK( std::abs(assignment.u[k]) <= 4 );
+	BOOST_CHECK( std::abs(assignment.v[k]) <= 4 );
+      }
+    }
+
+    void test_sigma_shared_rows() {
+      sigma_matrix sigma ( 3 );
+      sigma.insert(0, 0, -2);
+      sigma.insert(1, 0, -1);
+      sigma.insert(1, 1, -1);
+      sigma.insert(2, 1, -1);
+      sigma.insert(2, 2, 0);
+
+      /* a copy shares all rows */
+      const sigma_matrix copy = sigma;
+      BOOST_CHECK_EQUAL( &copy.row(1), &sigma.row(1) );
+
+      /* only the modified rows are copied */
+      sigma.insert(1, 2, -3);
+      sigma.erase(2, 1);
+      BOOST_CHECK( &copy.row(1) != &sigma.row(1) );
+      BOOST_CHECK( &copy.row(2) != &sigma.row(2) );
+      BOOST_CHECK_EQUAL( &copy.row(0), &sigma.row(0) );
+
+      BOOST_CHECK_EQUAL( copy(1, 2), BIG );
+      BOOST_CHECK_EQUAL( copy(2, 1), -1 );
+      BOOST_CHECK_EQUAL( sigma(1, 2), -3 );
+      BOOST_CHECK_EQUAL( sigma.smallest_cost_row(2), 1 );
+      BOOST_CHECK_EQUAL( copy.smallest_cost_row(2), 2 );
+
+      /* assign the copy back */
+      sigma = copy;
+      BOOST_CHECK_EQUAL( sigma.fingerprint(), copy.fingerprint() );
+      BOOST_CHECK_EQUAL( lap(sigma).cost, -3 );
+
+      /* reading a non-const matrix keeps its rows shared, only writing copies */
+      BOOST_CHECK_EQUAL( *sigma.find_element(0, 0), -2 );
+      BOOST_CHECK_EQUAL( &copy.row(0), &sigma.row(0) );
+      BOOST_CHECK_EQUAL( *sigma.mutable_element(0, 0), -2 );
+      BOOST_CHECK( &copy.row(0) != &sigma.row(0) );
+
+      /* rows can be shared by a matrix built from scratch */
+      sigma_matrix other ( 3 );
+      for (size_t i = 0; i < 3; i++)
+	other.share_row(i, copy, i);
+      BOOST_CHECK_EQUAL( other.fingerprint(), copy.fingerprint() );
+      BOOST_CHECK_EQUAL( other.minimum_row, copy.minimum_row );
+    }
+    void test_row_kernels() {
+      using namespace daestruct::kernels;
+      const isa initial = active_isa();
+      const isa all[] = { ISA_SCALAR, ISA_AVX2, ISA_AVX512 };
+
+      /* rows of every length around the vector widths, with many ties */
+      std::srand(42);
+      const size_t dim = 64;
+      sigma_matrix sigma ( dim );
+      for (size_t i = 0; i < dim; i++)
+	for (size_t j = 0; j < dim; j++)
+	  if (j <= i || std::rand() % 3 == 0)
+	    sigma.insert(i, j, -(std::rand() % 4));
+      std::vector<int> v(dim);
+      for (size_t j = 0; j < dim; j++)
+	v[j] = -(std::rand() % 3);
+
+      BOOST_REQUIRE( select_isa(ISA_SCALAR) );
+      const solution expected = lap(sigma);
+
+      for (const isa which : all) {
+	if (!select_isa(which))
+	  continue;
+
+	for (size_t i = 0; i < dim; i++) {
+	  const sigma_matrix::row_t& row = sigma.row(i);
+	  std::vector<int> h(row.nnz());
+	  reduced_costs(entries(row), row.nnz(), v.data(), h.data());
+
+	  size_t k = 0;
+	  for (auto it = row.begin(); it != row.end(); ++it, ++k)
+	    BOOST_CHECK_EQUAL( h[k], *it - v[it.index()] );
+
+	  /* the first minimum, then the first minimum of the rest */
+	  const two_smallest_t t = two_smallest(h.data(), h.size());
+	  const size_t first = std::min_element(h.begin(), h.end()) - h.begin();
+	  BOOST_CHECK_EQUAL( t.first, first );
+	  BOOST_CHECK_EQUAL( t.has_second, h.size() > 1 );
+	  if (t.has_second) {
+	    std::vector<int> rest(h);
+	    rest[first] = INT_MAX;
+	    BOOST_CHECK_EQUAL( t.second, size_t(std::min_element(rest.begin(), rest.end()) - rest.begin()) );
+	  }
+	}
+
+	const solution sol = lap(sigma);
+	BOOST_CHECK_EQUAL( sol.rowsol, expected.rowsol );
+	BOOST_CHECK_EQUAL( sol.v, expected.v );
+      }
+
+      select_isa(initial);
+    }
+
+    void test_fixed_point_threads() {
+      /* a random DAE with long chains of derivatives, i.e. many sweeps */
+      std::srand(7);
+      const size_t dim = 2000;
+      sigma_matrix sigma ( dim );
+      for (size_t i = 0; i < dim; i++) {
+	sigma.insert(i, i, 0);
+	if (i > 0 && std::rand() % 4 != 0)
+	  sigma.insert(i, i - 1, -(std::rand() % 3));
+	for (int k = 0; k < 2; k++)
+	  sigma.insert(i, std::rand() % dim, -(std::rand() % 2));
+      }
+
+      const solution sol = lap(sigma);
+      BOOST_REQUIRE_EQUAL( sol.unassigned, 0 );
+
+      std::vector<int> c(dim), d(dim);
+      analysis::solveByFixedPoint(sol.rowsol, sigma, c, d);
+      BOOST_CHECK( *std::max_element(d.begin(), d.end()) > 2 );
+
+      for (unsigned threads : { 2, 3, 8 }) {
+	std::vector<int> pc(dim), pd(dim);
+	analysis::solveByFixedPoint(sol.rowsol, sigma, pc, pd, threads);
+	BOOST_CHECK( pc == c );
+	BOOST_CHECK( pd == d );
+      }
+    }
+
+    void test_offsets_from_potentials() {
+      /* random DAEs, some of them with positive costs (i.e. negative derivatives) */
+      std::srand(11);
+      for (int round = 0; round < 20; round++) {
+	const size_t dim = 50 + std::rand() % 200;
+	sigma_matrix sigma ( dim );
+	for (size_t i = 0; i < dim; i++) {
+	  sigma.insert(i, i, -(std::rand() % 3));
+	  if (i > 0)
+	    sigma.insert(i, i - 1, -(std::rand() % 4));
+	  for (int k = 0; k < 3; k++)
+	    sigma.insert(i, std::rand() % dim, round % 2 ? 1 - std::rand() % 4 : -(std::rand() % 4));
+	}
+
+	const solution sol = lap(sigma);
+	BOOST_REQUIRE_EQUAL( sol.unassigned, 0 );
+
+	std::vector<int> c(dim), d(dim), pc, pd;
+	analysis::solveByFixedPoint(sol.rowsol, sigma, c, d);
+	analysis::solveByPotentials(sol.rowsol, sigma, sol.u, sol.v, pc, pd);
+	BOOST_CHECK( pc == c );
+	BOOST_CHECK( pd == d );
+      }
+
+      /*
+	    1  2
+	   ------
+	A | 0 -1 |
+	B |-1  0 |
+       */
+      sigma_matrix sigma ( 2 );
+      sigma.insert(0, 0, 0);
+      sigma.insert(0, 1, -1);
+      sigma.insert(1, 0, -1);
+      sigma.insert(1, 1, 0);
+      const solution sol = lap(sigma);
+      std::vector<int> c(2), d(2);
+
+      /* the diagonal is not optimal, the offsets would grow forever */
+      BOOST_CHECK_THROW( analysis::solveByFixedPoint({ 0, 1 }, sigma, c, d), std::invalid_argument );
+      BOOST_CHECK_THROW( analysis::solveByPotentials({ 0, 1 }, sigma, sol.u, sol.v, c, d), std::invalid_argument );
+
+      /* duals of some other problem */
+      BOOST_CHECK_THROW( analysis::solveByPotentials(sol.rowsol, sigma, { 0, 0 }, { 5, 5 }, c, d), std::invalid_argument );
+
+      sigma_matrix missing ( 2 );
+      missing.insert(0, 0, 0);
+      missing.insert(1, 0, 0);
+      missing.insert(1, 1, 0);
+      BOOST_CHECK_THROW( analysis::solveByFixedPoint({ 1, 0 }, missing, c, d), std::invalid_argument );
+
+      analysis::solveByPotentials(sol.rowsol, sigma, sol.u, sol.v, c, d);
+      BOOST_CHECK_EQUAL( c, std::vector<int>({ 0, 0 }) );
+      BOOST_CHECK_EQUAL( d, std::vector<int>({ 1, 1 }) );
+
+      /* raising the smallest cost of a column moves its minimum, or the LAP gets infeasible duals */
+      sigma.insert(1, 0, -3);
+      BOOST_CHECK_EQUAL( sigma.smallest_cost_row(0), 1 );
+      sigma.insert(1, 0, 0);
+      BOOST_CHECK_EQUAL( sigma.smallest_cost_row(0), 0 );
+    }
+
+    /* 
+     * sol has a feasible dual, tight on the assignment, and (if the assignment is complete) 
+     * the same offsets as the expected solution 
+     */
+    static void check_duals(const sigma_matrix& sigma, const solution& sol, const solution& expected) {
+      const size_t dim = sigma.dimension();
+      for (size_t i = 0; i < dim; i++) {
+	if (sol.rowsol[i] >= dim)
+	  continue;
+	BOOST_CHECK_EQUAL( sol.colsol[sol.rowsol[i]], i );
+	const sigma_matrix::row_t& row = sigma.row(i);
+	for (auto it = row.begin(); it != row.end(); ++it)
+	  BOOST_CHECK( sol.u[i] + sol.v[it.index()] <= *it );
+	BOOST_CHECK_EQUAL( sol.u[i] + sol.v[sol.rowsol[i]], sigma(i, sol.rowsol[i]) );
+      }
+
+      if (expected.unassigned == 0) {
+	std::vector<int> c, d, ec, ed;
+	analysis::solveByPotentials(sol.rowsol, sigma, sol.u, sol.v, c, d);
+	analysis::solveByPotentials(expected.rowsol, sigma, expected.u, expected.v, ec, ed);
+	BOOST_CHECK( c == ec );
+	BOOST_CHECK( d == ed );
+      }
+    }
+
+    /*
+     * a random matrix with a shifted diagonal and extra random entries per row, costs are
+     * positive too if allowed. Every fifth round leaves some rows without an own column.
+     */
+    static sigma_matrix random_sigma(size_t dim, int round, int extra, bool allow_positive) {
+      sigma_matrix sigma ( dim );
+      for (size_t i = 0; i < dim; i++) {
+	if (round % 5 != 4 || i % 7)
+	  sigma.insert(i, (i + round) % dim, -(std::rand() % 3));
+	for (int k = 0; k < extra; k++)
+	  sigma.insert(i, std::rand() % dim, allow_positive ? 5 - std::rand() % 9 : -(std::rand() % 4));
+      }
+      return sigma;
+    }
+
+    void test_LAP_cost_scaling() {
+      std::srand(3);
+      for (int round = 0; round < 30; round++) {
+	const size_t dim = 1 + std::rand() % 150;
+	const sigma_matrix sigma = random_sigma(dim, round, round % 5, round % 2);
+
+	const solution expected = lap(sigma);
+	const solution sol = lap_cost_scaling(sigma);
+	BOOST_CHECK_EQUAL( sol.unassigned, expected.unassigned );
+	if (expected.unassigned == 0)
+	  BOOST_CHECK_EQUAL( sol.cost, expected.cost );
+
+	/* tight duals, i.e. the offsets follow from them */
+	check_duals(sigma, sol, expected);
+      }
+
+      /* structurally singular: two rows share the only column they depend on */
+      sigma_matrix singular ( 3 );
+      singular.insert(0, 0, 0);
+      singular.insert(1, 0, 0);
+      singular.insert(2, 1, 0);
+      singular.insert(2, 2, 0);
+      BOOST_CHECK_EQUAL( lap_cost_scaling(singular).unassigned, 1 );
+    }
+
+    void test_LAP_phases() {
+      std::srand(4);
+      int complete = 0, singular = 0;
+      for (int round = 0; round < 30; round++) {
+	const size_t dim = 1 + std::rand() % 150;
+	const sigma_matrix sigma = random_sigma(dim, round, 1 + round % 4, false);
+
+	lap_options rows, phases;
+	rows.augmentation = AUGMENT_ROWS;
+	phases.augmentation = AUGMENT_PHASES;
+	rows.dense_small_matrices = phases.dense_small_matrices = false;
+	const solution expected = lap(sigma, rows);
+	const solution sol = lap(sigma, phases);
+	BOOST_CHECK_EQUAL( sol.unassigned, expected.unassigned );
+	/* a maximal assignment of a singular matrix depends on the order of the augmentations */
+	if (expected.unassigned > 0)
+	  ++singular;
+	else {
+	  ++complete;
+	  BOOST_CHECK_EQUAL( sol.cost, expected.cost );
+	  BOOST_CHECK_EQUAL( lap(sigma).cost, expected.cost );
+	}
+
+	check_duals(sigma, sol, expected);
+      }
+
+      /* both kinds of matrices were covered */
+      BOOST_CHECK( complete > 0 );
+      BOOST_CHECK( singular > 0 );
+    }
+
+    void test_LAP_parallel() {
+      std::srand(5);
+      size_t searches = 0, repeated = 0;
+      for (int round = 0; round < 30; round++) {
+	const size_t dim = 1 + std::rand() % 300;
+	const sigma_matrix sigma = random_sigma(dim, round, 1 + round % 4, false);
+
+	lap_options rows, parallel;
+	rows.augmentation = AUGMENT_ROWS;
+	parallel.augmentation = AUGMENT_PARALLEL;
+	parallel.threads = 4;
+	rows.dense_small_matrices = parallel.dense_small_matrices = false;
+	const solution expected = lap(sigma, rows);
+	const solution sol = lap(sigma, parallel);
+	BOOST_CHECK_EQUAL( sol.unassigned, expected.unassigned );
+	if (expected.unassigned == 0)
+	  BOOST_CHECK_EQUAL( sol.cost, expected.cost );
+	check_duals(sigma, sol, expected);
+
+	searches += sol.augmentations;
+	repeated += sol.repeated_searches;
+      }
+
+      /* some speculative searches were applied, some were repeated */
+      BOOST_CHECK( repeated > 0 );
+      BOOST_CHECK( 2 * repeated < searches );
+    }
+
+    void test_LAP_karp_sipser() {
+      lap_options karp_sipser, sparse;
+      karp_sipser.initialization = INIT_KARP_SIPSER;
+      karp_sipser.dense_small_matrices = sparse.dense_small_matrices = false;
+
+      /* a bidiagonal chain: only the degree-one rule matches it all */
+      const size_t n = 50;
+      sigma_matrix chain ( n );
+      for (size_t i = 0; i < n; i++) {
+	chain.insert(i, i, 0);
+	if (i + 1 < n)
+	  chain.insert(i, i + 1, 0);
+      }
+      const solution matched = lap(chain, karp_sipser);
+      BOOST_CHECK_EQUAL( matched.initialized_rows, n );
+      BOOST_CHECK_EQUAL( matched.row_reduced_rows, 0 );
+      BOOST_CHECK_EQUAL( matched.augmented_rows, 0 );
+
+      std::srand(6);
+      for (int round = 0; round < 30; round++) {
+	const size_t dim = 1 + std::rand() % 150;
+	const sigma_matrix sigma = random_sigma(dim, round, round % 4, false);
+
+	const solution expected = lap(sigma, sparse);
+	const solution sol = lap(sigma, karp_sipser);
+	BOOST_CHECK_EQUAL( sol.unassigned, expected.unassigned );
+	if (expected.unassigned == 0)
+	  BOOST_CHECK_EQUAL( sol.cost, expected.cost );
+	check_duals(sigma, sol, expected);
+
+	/* every assigned row is counted by one of the stages */
+	BOOST_CHECK_EQUAL( sol.initialized_rows + sol.row_reduced_rows + sol.augmented_rows, dim - sol.unassigned );
+	BOOST_CHECK_EQUAL( expected.initialized_rows + expected.row_reduced_rows + expected.augmented_rows, 
+			   dim - expected.unassigned );
+      }
+    }
+
+    void test_LAP_dense() {
+      lap_options sparse;
+      sparse.dense_small_matrices = false;
+
+      std::srand(9);
+      int complete = 0, singular = 0;
+      for (int round = 0; round < 60; round++) {
+	const size_t dim = 1 + std::rand() % 32;
+	const sigma_matrix sigma = random_sigma(dim, round, round % 6, round % 2);
+
+	const solution expected = lap(sigma, sparse);
+	const solution sol = lap(sigma);
+	BOOST_CHECK_EQUAL( sol.unassigned, expected.unassigned );
+	if (expected.unassigned == 0)
+	  BOOST_CHECK_EQUAL( sol.cost, expected.cost );
+	check_duals(sigma, sol, expected);
+
+	/* the singular ones are left to the sparse version */
+	if (expected.unassigned > 0)
+	  singular++;
+	else
+	  complete++;
+      }
+
+      BOOST_CHECK( complete > 0 );
+      BOOST_CHECK( singular > 0 );
+    }
+
+    void test_LAP_delta_free_rows() {
+      std::srand(11);
+      for (int round = 0; round < 30; round++) {
+	/* large and small matrices alternate, so the kept search state is reused and grown */
+	const size_t dim = 2 + std::rand() % (round % 2 ? 20 : 200);
+	const sigma_matrix sigma = random_sigma(dim, round, 1 + round % 4, false);
+	const solution expected = lap(sigma);
+	if (expected.unassigned > 0)
+	  continue;
+
+	/* unassign a few rows, like deleted assignments */
+	solution warm = expected;
+	std::vector<index_t> free;
+	int cost = warm.cost;
+	for (size_t i = round % 3; i < dim; i += 1 + dim / 4) {
+	  cost -= sigma(i, warm.rowsol[i]);
+	  warm.colsol[warm.rowsol[i]] = BIG;
+	  warm.rowsol[i] = BIG;
+	  free.push_back(i);
+	}
+
+	const solution sol = delta_lap(sigma, std::move(warm.u), std::move(warm.v), 
+				       std::move(warm.rowsol), std::move(warm.colsol), cost, free);
+	BOOST_CHECK_EQUAL( sol.unassigned, 0 );
+	BOOST_CHECK_EQUAL( sol.cost, expected.cost );
+	BOOST_CHECK_EQUAL( sol.augmentations, free.size() );
+	check_duals(sigma, sol, expected);
+      }
+    }
+
+    void test_LAP_cancelled() {
+      std::srand(10);
+      const size_t dim = 100;
+      const sigma_matrix sigma = random_sigma(dim, 0, 3, false);
+      const solution expected = lap(sigma);
+      BOOST_CHECK_EQUAL( expected.unassigned, 0 );
+
+      std::atomic<bool> cancel(true);
+      lap_options cancelled;
+      cancelled.cancel = &cancel;
+
+      /* nothing is augmented after the initialization */
+      const solution sol = lap(sigma, cancelled);
+      BOOST_CHECK_EQUAL( sol.augmented_rows, 0 );
+      BOOST_CHECK_EQUAL( sol.initialized_rows + sol.row_reduced_rows + sol.unassigned, dim );
+
+      BOOST_CHECK_EQUAL( lap_cost_scaling(sigma, cancelled).unassigned, dim );
+
+      /* the free row of a warm start stays free */
+      for (const bool stop : {true, false}) {
+	cancel = stop;
+	solution warm = expected;
+	warm.colsol[warm.rowsol[0]] = BIG;
+	warm.rowsol[0] = BIG;
+	const int cost = warm.cost - sigma(0, expected.rowsol[0]);
+	const solution delta = delta_lap(sigma, std::move(warm.u), std::move(warm.v), 
+					 std::move(warm.rowsol), std::move(warm.colsol), cost, cancelled);
+	BOOST_CHECK_EQUAL( delta.unassigned, stop ? 1 : 0 );
+	if (!stop)
+	  BOOST_CHECK_EQUAL( delta.cost, expected.cost );
+      }
     }
   }
 }
@@ -35,6 +35,32 @@ namespace daestruct {
 
     void test_LAP_on_identity();
 
+    void test_LAP_singular();
+
+    void test_LAP_single_entries();
+
+    void test_sigma_shared_rows();
+
+    void test_row_kernels();
+
+    void test_fixed_point_threads();
+
+    void test_offsets_from_potentials();
+
+    void test_LAP_cost_scaling();
+
+    void test_LAP_phases();
+
+    void test_LAP_parallel();
+
+    void test_LAP_karp_sipser();
+
+    void test_LAP_dense();
+
+    void test_LAP_delta_free_rows();
+
+    void test_LAP_cancelled();
+
   }
 }
 